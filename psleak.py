@@ -6,24 +6,40 @@
 extensions.
 """
 
+import argparse
+import asyncio
 import collections
+import ctypes
 import functools
 import gc
+import hashlib
+import json
 import linecache
 import logging
+import math
 import os
+import pickle
 import sys
 import threading
+import time
+import tracemalloc
 import types
 import unittest
 import warnings
 from dataclasses import dataclass
 
 import psutil
+from psutil import LINUX
 from psutil import POSIX
 from psutil import WINDOWS
+from psutil._common import popenfile
 from psutil._common import print_color
 
+try:
+    import _psleak_ext  # optional C accelerator, see Makefile "build"
+except ImportError:
+    _psleak_ext = None
+
 thisproc = psutil.Process()
 
 
@@ -56,6 +72,11 @@ class UnclosedResourceError(Error):
             msg += ":" + "".join(f"\n* {extra!r}" for extra in extras)
         super().__init__(msg)
 
+    def __reduce__(self):
+        # preserve exception type when sent over a pipe by an isolated
+        # worker process
+        return (self.__class__, (self.count, self.fun_name, self.extras))
+
 
 class UnclosedFdError(UnclosedResourceError):
     """Raised when an unclosed file descriptor is detected after
@@ -100,6 +121,36 @@ class UnclosedPythonThreadError(UnclosedResourceError):
     resource_name = "Python thread"
 
 
+class UnclosedAsyncResourceError(UnclosedResourceError):
+    """Raised when an asyncio task is left pending or a transport left
+    unclosed on the event loop driven by execute_async() after calling
+    the coroutine once.
+    """
+
+    resource_name = "pending asyncio task or unclosed transport"
+    verb = "lingering"
+
+
+class UnclosedChildProcessError(UnclosedResourceError):
+    """Raised when a child process spawned during a function call is
+    still alive after it (e.g. a fork()ed helper which was never
+    waited on). Only checked in `track_children` mode.
+    """
+
+    resource_name = "child process"
+    verb = "leftover"
+
+
+class UnclosedMmapRegionError(UnclosedResourceError):
+    """Raised when anonymous memory mappings created during a function
+    call are still mapped after it (mmap() without munmap()). Only
+    checked in `track_mmap_regions` mode. Linux only.
+    """
+
+    resource_name = "mmap region"
+    verb = "leftover"
+
+
 class UncollectableGarbageError(UnclosedResourceError):
     """Raised when objects with __del__ are left in gc.garbage after a call."""
 
@@ -117,6 +168,19 @@ class MemoryLeakError(Error):
     - `VirtualAlloc()` without `VirtualFree()` (Windows)
     """
 
+    # {metric: {"runs", "mean", "min", "slope"}} accumulated over the
+    # measurement runs which led to the failure; set by _check_mem().
+    stats = None
+
+
+class InconclusiveError(Error):
+    """Raised when a leak test exhausts its wall-clock budget (see
+    `MemoryLeakTestCase.time_budget` and the `PSLEAK_SESSION_BUDGET`
+    env var) before memory either stabilizes or keeps growing long
+    enough to call it a leak. Deliberately distinct from
+    `MemoryLeakError`: the test neither passed nor failed.
+    """
+
 
 # --- utils
 
@@ -134,6 +198,26 @@ def format_run_line(idx, diffs, times):
     return s
 
 
+def fit_slope(xs, ys):
+    """Least-squares linear fit of ys over xs. Return (slope, stderr),
+    stderr being the standard error of the slope estimate.
+    """
+    n = len(xs)
+    mean_x = sum(xs) / n
+    mean_y = sum(ys) / n
+    sxx = sum((x - mean_x) ** 2 for x in xs)
+    if sxx == 0:
+        return (0.0, 0.0)
+    sxy = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    slope = sxy / sxx
+    if n <= 2:
+        return (slope, 0.0)
+    intercept = mean_y - slope * mean_x
+    ss_resid = sum((y - (intercept + slope * x)) ** 2 for x, y in zip(xs, ys))
+    stderr = math.sqrt(ss_resid / (n - 2) / sxx)
+    return (slope, stderr)
+
+
 def qualname(obj):
     """Return a human-readable qualified name for a function, method or
     class.
@@ -141,11 +225,19 @@ def qualname(obj):
     return getattr(obj, "__qualname__", getattr(obj, "__name__", str(obj)))
 
 
+_caches_warmed = False
+
+
 def warm_caches():
     """Avoid potential false positives due to various caches filling
     slowly with random data, usually happening on the very first run.
-    Taken from cPython's refleak.py.
+    Taken from cPython's refleak.py. The caches are process-global, so
+    this runs only once no matter how many test instances call it.
     """
+    global _caches_warmed  # noqa: PLW0603
+    if _caches_warmed:
+        return
+    _caches_warmed = True
     # char cache
     s = bytes(range(256))
     for i in range(256):
@@ -177,6 +269,14 @@ class GCDebugger:
     Detection is performed using a context manager that temporarily
     enables gc.DEBUG_SAVEALL and tracks objects remaining in
     gc.garbage.
+
+    By default it runs a full (generation 2) collection on both enter
+    and exit, which on multi-million-object heaps can cost seconds per
+    test. With `generation` < 2 only that young generation is swept at
+    the window edges, which is enough to catch garbage created inside
+    the window; a gc.callbacks hook tracks collections which happen
+    during the window, so if the interpreter promoted objects to an
+    older generation in the meantime, the exit sweep extends to it.
     """
 
     # Objects that are temporarily part of a cycle but are expected to
@@ -202,57 +302,115 @@ class GCDebugger:
         type(None),
     )
 
+    # Exact types which can be classified without isinstance() chains
+    # (fast path; subclasses go through the isinstance() checks below).
+    _SCALAR_EXACT = frozenset({
+        int,
+        float,
+        bool,
+        str,
+        bytes,
+        bytearray,
+        complex,
+        type(None),
+    })
+    _CONTAINER_EXACT = frozenset({list, tuple, set, frozenset})
+
+    def __init__(self, generation=2):
+        if generation not in (0, 1, 2):
+            msg = f"generation must be 0, 1 or 2 (got {generation!r})"
+            raise ValueError(msg)
+        self.generation = generation
+        self.before = []
+        self.after = []
+        # highest generation collected while inside the window
+        self._max_gen = generation
+        # memoized is_transient() verdicts keyed by id(); valid for the
+        # lifetime of this instance because before/after keep the
+        # inspected objects alive
+        self._memo = {}
+
+    def _on_collect(self, phase, info):
+        if phase == "start":
+            self._max_gen = max(self._max_gen, info["generation"])
+
     def __enter__(self):
         self._old_debug = gc.get_debug()
         gc.set_debug(gc.DEBUG_SAVEALL)
-        gc.collect()
+        gc.collect(self.generation)
         self.before = list(gc.garbage)
         self.after = []
         gc.garbage.clear()
+        if self.generation < 2:
+            gc.callbacks.append(self._on_collect)
         return self
 
     def __exit__(self, *a, **k):
-        gc.collect()
+        if self.generation < 2:
+            gc.callbacks.remove(self._on_collect)
+        gc.collect(self._max_gen)
         self.after = list(gc.garbage)
         gc.garbage.clear()
         gc.set_debug(self._old_debug)
 
-    def is_transient(self, obj, _seen=None):
-        if _seen is None:
-            _seen = set()
-
-        oid = id(obj)
-        if oid in _seen:
-            return True
-
-        _seen.add(oid)
-
-        if isinstance(obj, self.TRANSIENT_TYPES):
-            return True
-
-        if isinstance(obj, self.SCALAR_TYPES):
-            return True
-
-        if isinstance(obj, (list, tuple, set, frozenset)):
-            for o in obj:  # noqa: SIM110
-                if not self.is_transient(o, _seen):
-                    return False
-            return True
-
-        if isinstance(obj, dict):
-            for k, v in obj.items():
-                if not self.is_transient(k, _seen):
-                    return False
-                if not self.is_transient(v, _seen):
-                    return False
-            return True
-
-        return False
+    def is_transient(self, obj):
+        memo = self._memo
+        verdict = memo.get(id(obj))
+        if verdict is not None:
+            return verdict
+
+        # Iterative worklist (gc.garbage may hold hundreds of
+        # thousands of objects; recursing would be slow and can hit
+        # the recursion limit on deep graphs). Objects revisited due
+        # to cycles are skipped, i.e. considered transient.
+        stack = [obj]
+        seen = set()
+        while stack:
+            o = stack.pop()
+            oid = id(o)
+            if oid in seen:
+                continue
+            seen.add(oid)
+            cached = memo.get(oid)
+            if cached is True:
+                continue
+            if cached is None:
+                typ = type(o)
+                if typ in self._SCALAR_EXACT:
+                    continue
+                if typ in self._CONTAINER_EXACT:
+                    stack.extend(o)
+                    continue
+                if typ is dict:
+                    stack.extend(o.keys())
+                    stack.extend(o.values())
+                    continue
+                if isinstance(o, self.TRANSIENT_TYPES):
+                    continue
+                if isinstance(o, self.SCALAR_TYPES):
+                    continue
+                if isinstance(o, (list, tuple, set, frozenset)):
+                    stack.extend(o)
+                    continue
+                if isinstance(o, dict):
+                    stack.extend(o.keys())
+                    stack.extend(o.values())
+                    continue
+            # non-transient (or memoized as such)
+            memo[id(obj)] = False
+            return False
+
+        for oid in seen:
+            memo[oid] = True
+        return True
 
     def leaked_objects(self):
+        # membership by identity: an O(1) set lookup instead of the
+        # O(n) equality scan a list would do for each object
+        before_ids = {id(x) for x in self.before}
         leaked = []
         for obj in self.after:
-            if obj in self.before:
+            if id(obj) in before_ids:
                 continue
             if self.is_transient(obj):
                 continue
@@ -282,6 +440,8 @@ class Checkers:
     # Python stuff
     py_threads: bool = True
     gcgarbage: bool = True
+    # asyncio stuff (only meaningful with execute_async())
+    async_tasks: bool = True
 
     @classmethod
     def _validate(cls, check_names):
@@ -308,12 +468,290 @@ class Checkers:
         return cls(**kwargs)
 
 
+def _count_async_resources(loop):
+    """Return a (count, extras) snapshot of the pending tasks and
+    unclosed transports on `loop` (None when no loop is being driven,
+    i.e. outside execute_async()).
+    """
+    if loop is None or loop.is_closed():
+        return (0, [])
+    tasks = [t for t in asyncio.all_tasks(loop) if not t.done()]
+    # _transports is a WeakValueDictionary {fd: transport} kept by the
+    # selector/proactor event loops; there is no public registry
+    transports = [
+        t
+        for t in getattr(loop, "_transports", {}).values()
+        if not t.is_closing()
+    ]
+    return (len(tasks) + len(transports), tasks + transports)
+
+
+# custom resource checkers, see register_checker()
+_checker_registry = {}  # {name: (counter, extras, exception)}
+
+_BUILTIN_CHECKER_NAMES = frozenset({
+    "async_tasks",
+    "c_threads",
+    "child_procs",
+    "heap_count",
+    "mmap_regions",
+    "num_fds",
+    "num_handles",
+    "py_threads",
+})
+
+
+def _diff_extras(_case, before, after):
+    """Default lazy extras resolver: the tokens captured by the
+    counter, set-diffed so only resources which appeared are reported.
+    """
+    return set(after) - set(before)
+
+
+def register_checker(name, counter, exception, extras=None):
+    """Register a custom resource checker, run alongside the built-in
+    ones by every execute():
+
+    - `counter`: argument-less callable returning an int; called once
+      before and once after the function call, so it must be cheap.
+    - `exception`: UnclosedResourceError subclass raised if the
+      counter grew.
+    - `extras`: optional argument-less callable enumerating the
+      resources for the error message; only called when the check
+      actually fails, so it may be expensive.
+
+    Example::
+
+        class CudaContextLeakError(psleak.UnclosedResourceError):
+            resource_name = "CUDA context"
+
+        psleak.register_checker(
+            "cuda_contexts",
+            counter=count_cuda_contexts,  # 1ms
+            exception=CudaContextLeakError,
+            extras=list_cuda_contexts,  # 300ms, failure path only
+        )
+    """
+    assert_isinstance("name", name, str)
+    assert_isinstance("counter", counter, collections.abc.Callable)
+    if extras is not None:
+        assert_isinstance("extras", extras, collections.abc.Callable)
+    if not (
+        isinstance(exception, type)
+        and issubclass(exception, UnclosedResourceError)
+    ):
+        msg = (
+            "'exception' must be an UnclosedResourceError subclass"
+            f" (got {exception!r})"
+        )
+        raise TypeError(msg)
+    if name in _BUILTIN_CHECKER_NAMES:
+        msg = f"{name!r} is a built-in checker"
+        raise ValueError(msg)
+    if name in _checker_registry:
+        msg = f"checker {name!r} is already registered"
+        raise ValueError(msg)
+    _checker_registry[name] = (counter, extras, exception)
+    _compile_checkers.cache_clear()  # plans must be rebuilt
+
+
+def unregister_checker(name):
+    """Remove a checker previously added via register_checker()."""
+    if name not in _checker_registry:
+        msg = f"no registered checker named {name!r}"
+        raise ValueError(msg)
+    del _checker_registry[name]
+    _compile_checkers.cache_clear()
+
+
+class _CheckerPlan:
+    """Platform-resolved compilation of a Checkers config: an ordered
+    tuple of (name, counter, extras, exception) entries, one per
+    counter to snapshot, with the `POSIX and checkers.fds`-style
+    branches evaluated once instead of on every snapshot. Each counter
+    takes (case, snap), `snap` being the (num_fds, num_c_threads,
+    child_pids, tids) tuple from _snap_counts(), and returns a cheap
+    (count, token) pair; the extras callable takes (case,
+    token_before, token_after) and resolves the expensive resource
+    enumeration only when the check failed. Since Checkers is frozen
+    (hence hashable), plans are built once per distinct config via
+    _compile_checkers() no matter how many tests share it.
+    """
+
+    __slots__ = (
+        "entries",
+        "exceptions",
+        "extras",
+        "gcgarbage",
+        "memory",
+        "want_fds",
+        "want_threads",
+    )
+
+    def __init__(self, checkers, track_children=False, mmap_regions=False):
+        self.memory = checkers.memory
+        self.gcgarbage = checkers.gcgarbage
+        self.want_fds = bool(POSIX and checkers.fds)
+        self.want_threads = checkers.c_threads
+        entries = []
+        if checkers.py_threads:
+            entries.append((
+                "py_threads",
+                lambda _case, _snap: (
+                    threading.active_count(),
+                    threading.enumerate(),
+                ),
+                _diff_extras,
+                UnclosedPythonThreadError,
+            ))
+        if self.want_fds:
+            entries.append((
+                "num_fds",
+                lambda case, snap: (snap[0], case._cached_fds),
+                lambda case, _before, _after: case._diff_fds(),
+                UnclosedFdError,
+            ))
+        if WINDOWS and checkers.handles:
+            entries.append((
+                "num_handles",
+                lambda case, _snap: case._snap_handles(),
+                # per-type counts from the native handle snapshot, or
+                # the fd-diff fallback when the C ext is unavailable
+                lambda case, before, after: (
+                    case._diff_handle_types(before, after)
+                    if isinstance(after, dict)
+                    else case._diff_fds()
+                ),
+                UnclosedHandleError,
+            ))
+        if self.want_threads:
+            entries.append((
+                "c_threads",
+                lambda _case, snap: (snap[1], snap[3]),
+                # thisproc.threads() re-parses /proc per thread: only
+                # worth paying once the check failed
+                lambda case, before, after: case._diff_native_threads(
+                    before, after
+                ),
+                UnclosedNativeThreadError,
+            ))
+        if WINDOWS and checkers.memory:
+            entries.append((
+                "heap_count",
+                lambda _case, _snap: (psutil.heap_info().heap_count, None),
+                lambda _case, _before, _after: [],
+                UnclosedHeapCreateError,
+            ))
+        if checkers.async_tasks:
+            entries.append((
+                "async_tasks",
+                lambda case, _snap: _count_async_resources(case._async_loop),
+                _diff_extras,
+                UnclosedAsyncResourceError,
+            ))
+        if track_children:
+            entries.append((
+                "child_procs",
+                lambda _case, snap: (len(snap[2]), snap[2]),
+                _diff_extras,
+                UnclosedChildProcessError,
+            ))
+        if mmap_regions:
+            entries.append((
+                "mmap_regions",
+                lambda case, _snap: case._snap_mmap_regions(),
+                # the full maps re-parse with region sizes happens on
+                # the failure path only; the counter just hashes
+                lambda case, before, _after: case._diff_mmap_regions(before),
+                UnclosedMmapRegionError,
+            ))
+        for name, (counter, extras, exception) in _checker_registry.items():
+            entries.append((
+                name,
+                lambda _case, _snap, counter=counter: (counter(), None),
+                lambda _case, _before, _after, extras=extras: (
+                    list(extras()) if extras is not None else None
+                ),
+                exception,
+            ))
+        self.entries = tuple(entries)
+        self.extras = {name: ext for name, _, ext, _ in entries}
+        self.exceptions = {name: exc for name, _, _, exc in entries}
+
+
+@functools.lru_cache(maxsize=None)
+def _compile_checkers(checkers, track_children=False, mmap_regions=False):
+    return _CheckerPlan(checkers, track_children, mmap_regions)
+
+
 # ---
 
 _warnings_emitted = False
+_native_sampler_broken = False
+_native_handles_broken = False
+_interpose_counters = None
+_calibrated_tolerances = None
+_session_deadline = None
+# underlying functions already warmed up by an auto_generate() sibling
+# test in this process (see MemoryLeakTestCase._warm_group)
+_warmed_groups = set()
+
+
+class _Deadline:
+    """Tracks a wall-clock budget, in seconds, from creation time."""
+
+    def __init__(self, budget):
+        self.budget = budget
+        self.started = time.monotonic()
+
+    def remaining(self):
+        return self.budget - (time.monotonic() - self.started)
+
+    def allows(self, secs):
+        """Whether a run expected to last `secs` seconds still fits."""
+        return secs <= self.remaining()
+
+
+def _get_deadline(time_budget):
+    """Return the tighter of the per-test budget and the per-session
+    one (PSLEAK_SESSION_BUDGET env var, seconds, started on the first
+    execute() of the process), or None if neither is set.
+    """
+    global _session_deadline  # noqa: PLW0603
+    if _session_deadline is None:
+        budget = os.environ.get("PSLEAK_SESSION_BUDGET")
+        _session_deadline = _Deadline(float(budget)) if budget else False
+    deadlines = []
+    if time_budget is not None:
+        deadlines.append(_Deadline(time_budget))
+    if _session_deadline:
+        deadlines.append(_session_deadline)
+    if not deadlines:
+        return None
+    return min(deadlines, key=lambda d: d.remaining())
+
+
+def _load_interpose():
+    """If the psleak_interpose.so LD_PRELOAD library is loaded (see
+    "make build-interpose") return its (heap, mmap) outstanding-bytes
+    counters as ctypes values, else False. Probed once per process.
+    """
+    global _interpose_counters  # noqa: PLW0603
+    if _interpose_counters is None:
+        _interpose_counters = False
+        if "psleak_interpose" in os.environ.get("LD_PRELOAD", ""):
+            try:
+                lib = ctypes.CDLL(None)
+                _interpose_counters = (
+                    ctypes.c_long.in_dll(lib, "psleak_interpose_heap_bytes"),
+                    ctypes.c_long.in_dll(lib, "psleak_interpose_mmap_bytes"),
+                )
+            except (OSError, ValueError):
+                pass
+    return _interpose_counters
 
 
-def _emit_warnings():
+def _emit_warnings(isolate=False):
     global _warnings_emitted  # noqa: PLW0603
 
     def warn(msg, suffix="memory leak detection may be less reliable"):
@@ -332,10 +770,10 @@ def _emit_warnings():
     if os.environ.get("PYTHONUNBUFFERED") != "1":
         warn("PYTHONUNBUFFERED=1 environment variable was not set")
 
-    if "PYTEST_XDIST_WORKER" in os.environ:
+    if "PYTEST_XDIST_WORKER" in os.environ and not isolate:
         warn(
             "memory leak detection is unreliable when running tests in"
-            " parallel via pytest-xdist",
+            " parallel via pytest-xdist (consider setting isolate=True)",
             suffix="",
         )
 
@@ -349,19 +787,277 @@ def _emit_warnings():
     _warnings_emitted = True
 
 
+def _hash_target(fun):
+    """Return a stable hash of the code behind a callable, or None if
+    it cannot be computed reliably. Pure Python functions hash their
+    bytecode + consts; C extension functions hash the extension's build
+    artifact, so a rebuilt .so invalidates the cache.
+    """
+    parts = []
+    while isinstance(fun, functools.partial):
+        parts.append(repr(fun.args) + repr(sorted(fun.keywords.items())))
+        fun = fun.func
+    parts.append(qualname(fun))
+    code = getattr(fun, "__code__", None)
+    if code is not None:
+        payload = code.co_code + repr(code.co_consts).encode()
+    else:
+        mod = sys.modules.get(getattr(fun, "__module__", None) or "")
+        path = getattr(mod, "__file__", None)
+        if path is None or not os.path.isfile(path):
+            return None
+        try:
+            with open(path, "rb") as file:
+                payload = file.read()
+        except OSError:
+            return None
+    sha = hashlib.sha1(payload)  # noqa: S324
+    sha.update("|".join(parts).encode())
+    return sha.hexdigest()
+
+
+class _ResultCache:
+    """Tiny on-disk JSON store of passed leak tests, keyed by target
+    code hash + effective options. Lets unchanged targets skip the
+    expensive memory check escalation loop on later runs.
+    """
+
+    def __init__(self, path):
+        self.path = path
+
+    def load(self):
+        try:
+            with open(self.path) as file:
+                return json.load(file)
+        except (OSError, ValueError):
+            return {}
+
+    def has(self, key):
+        return key in self.load()
+
+    def add(self, key):
+        data = self.load()
+        data[key] = time.time()
+        try:
+            with open(self.path, "w") as file:
+                json.dump(data, file)
+        except OSError:
+            pass
+
+
+class _SampleRing:
+    """Fixed-capacity ring buffer of (ncalls, timestamp, mem dict)
+    samples recorded during the measurement loops (see
+    MemoryLeakTestCase.samples_dir). Slots are preallocated so that
+    recording appends nothing inside the measured window; once full,
+    the oldest samples are overwritten.
+    """
+
+    def __init__(self, capacity):
+        self.capacity = capacity
+        self.total = 0
+        self._slots = [None] * capacity
+        self._next = 0
+
+    def add(self, ncalls, mem):
+        self._slots[self._next] = (ncalls, time.monotonic(), mem)
+        self._next = (self._next + 1) % self.capacity
+        self.total += 1
+
+    def rows(self):
+        """Recorded samples, oldest first."""
+        if self.total <= self.capacity:
+            return self._slots[: self.total]
+        return self._slots[self._next :] + self._slots[: self._next]
+
+    def export_csv(self, path):
+        rows = self.rows()
+        keys = sorted(rows[0][2])
+        t0 = rows[0][1]
+        with open(path, "w") as file:
+            file.write("ncalls,elapsed," + ",".join(keys) + "\n")
+            for ncalls, ts, mem in rows:
+                values = ",".join(str(mem[k]) for k in keys)
+                file.write(f"{ncalls},{ts - t0:.6f},{values}\n")
+
+    def export_trace(self, path, name):
+        """Write samples in the Chrome trace-event format (one counter
+        track per metric); load via chrome://tracing or
+        https://ui.perfetto.dev.
+        """
+        rows = self.rows()
+        t0 = rows[0][1]
+        pid = os.getpid()
+        events = [{
+            "ph": "M",
+            "name": "process_name",
+            "pid": pid,
+            "args": {"name": name},
+        }]
+        for _ncalls, ts, mem in rows:
+            events.extend(
+                {
+                    "ph": "C",
+                    "name": k,
+                    "pid": pid,
+                    "tid": 0,
+                    "ts": int((ts - t0) * 1e6),
+                    "args": {k: v},
+                }
+                for k, v in mem.items()
+            )
+        with open(path, "w") as file:
+            json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, file)
+
+
+class _Telemetry:
+    """Collects per-phase timings and per-run memory diffs for a
+    single execute() call and appends them to a JSONL sink file, so
+    that slow / retry-hungry tests can be spotted offline. Enabled via
+    MemoryLeakTestCase.telemetry_path or the PSLEAK_TELEMETRY env var.
+    """
+
+    def __init__(self, path, test, fun):
+        self.path = path
+        self.started = time.monotonic()
+        self.rec = {
+            "test": test.id(),
+            "fun": qualname(fun),
+            "timestamp": time.time(),
+            "phases": {},  # {phase name: cumulative seconds}
+            "runs": [],  # one entry per _call_ntimes() run
+        }
+
+    def add_phase(self, name, elapsed):
+        phases = self.rec["phases"]
+        phases[name] = phases.get(name, 0.0) + elapsed
+
+    def add_run(self, diffs, times):
+        self.rec["runs"].append({"diffs": diffs, "times": times})
+
+    def write(self, outcome):
+        self.rec["outcome"] = outcome
+        self.rec["elapsed"] = time.monotonic() - self.started
+        with open(self.path, "a") as file:
+            file.write(json.dumps(self.rec) + "\n")
+
+
+class _RunStats:
+    """Streaming per-metric statistics (count, mean, min and a
+    least-squares trend) over the measurement runs of a single
+    _check_mem() invocation. Stability is judged on the trend of the
+    whole diff history rather than on the previous run only, so a
+    single lucky low sample can no longer end the escalation early and
+    a single unlucky one no longer costs a full extra run. One fixed
+    slot of accumulators per metric; no per-run dict churn.
+    """
+
+    __slots__ = ("_slots",)
+
+    # accumulator indexes within a metric's slot
+    _N, _SUMY, _MIN, _SUMX, _SUMXY, _SUMXX = range(6)
+
+    def __init__(self):
+        self._slots = {}  # {metric: [n, sum(y), min, sx, sxy, sxx]}
+
+    def add(self, diffs):
+        """Record the per-metric diffs of one measurement run."""
+        for metric, value in diffs.items():
+            slot = self._slots.get(metric)
+            if slot is None:
+                slot = self._slots[metric] = [0.0] * 6
+                slot[self._MIN] = value
+            x = slot[self._N] = slot[self._N] + 1
+            slot[self._SUMY] += value
+            slot[self._MIN] = min(slot[self._MIN], value)
+            slot[self._SUMX] += x
+            slot[self._SUMXY] += x * value
+            slot[self._SUMXX] += x * x
+
+    def trend(self, metric):
+        """Least-squares slope of the metric's diffs over the run
+        index, or +inf while fewer than 2 runs were recorded (one
+        sample has no trend: not stable yet).
+        """
+        slot = self._slots.get(metric)
+        if slot is None or slot[self._N] < 2:
+            return math.inf
+        n = slot[self._N]
+        denom = n * slot[self._SUMXX] - slot[self._SUMX] ** 2
+        return (
+            n * slot[self._SUMXY] - slot[self._SUMX] * slot[self._SUMY]
+        ) / denom
+
+    def summary(self):
+        """{metric: {"runs", "mean", "min", "slope"}} for reporting on
+        MemoryLeakError.
+        """
+        out = {}
+        for metric, slot in self._slots.items():
+            n = int(slot[self._N])
+            trend = self.trend(metric)
+            out[metric] = {
+                "runs": n,
+                "mean": slot[self._SUMY] / n,
+                "min": slot[self._MIN],
+                "slope": None if trend is math.inf else trend,
+            }
+        return out
+
+
 class LeakTest:
     """Small helper object to use in conjunction with
     ``MemoryLeakTestCase.auto_generate``.
+
+    `setup` and `teardown` are optional callables isolating the
+    sub-phases of a composite target (e.g. a dispatcher): when the
+    test fails and ``bisect_on_failure`` is enabled, each registered
+    phase is re-measured separately to narrow down which one leaks.
     """
 
-    __slots__ = ("args", "execute_kwargs", "fun")
+    __slots__ = (
+        "args",
+        "execute_kwargs",
+        "fun",
+        "setup",
+        "teardown",
+        "variants",
+    )
 
-    def __init__(self, fun, *args, **execute_kwargs):
+    def __init__(
+        self, fun, *args, setup=None, teardown=None, **execute_kwargs
+    ):
         assert_isinstance("fun", fun, collections.abc.Callable)
+        if setup is not None:
+            assert_isinstance("setup", setup, collections.abc.Callable)
+        if teardown is not None:
+            assert_isinstance("teardown", teardown, collections.abc.Callable)
         self.fun = fun
         self.args = args
+        self.setup = setup
+        self.teardown = teardown
+        self.variants = None
         self.execute_kwargs = dict(execute_kwargs)
 
+    @classmethod
+    def matrix(cls, fun, args_list, **execute_kwargs):
+        """Sweep-aware form: one LeakTest measuring `fun` over many
+        argument variants in a single interleaved session (see
+        MemoryLeakTestCase.execute_matrix()) instead of one fully
+        independent test per variant, each with its own warmup, trims
+        and escalation. Items of `args_list` are argument tuples; bare
+        values are treated as a single argument.
+        """
+        test = cls(fun, **execute_kwargs)
+        test.variants = tuple(
+            args if isinstance(args, tuple) else (args,)
+            for args in args_list
+        )
+        if not test.variants:
+            msg = "'args_list' must be a non-empty sequence"
+            raise ValueError(msg)
+        return test
+
     def _make_callable(self):
         if self.args:
             return functools.partial(self.fun, *self.args)
@@ -378,18 +1074,147 @@ class MemoryLeakTestCase(unittest.TestCase):
     # Allowed memory growth (in bytes or per-metric) before it is
     # considered a leak.
     tolerance = 0
+    # If True (and no explicit tolerance is set) derive per-metric
+    # tolerances from the allocator jitter observed while measuring a
+    # no-op function. Calibration runs once per process.
+    auto_tolerance = False
+    # Number of no-op measurement runs used for calibration.
+    calibration_runs = 3
+    # Memory check strategy: "escalate" re-runs with times increased by
+    # 50% until growth stops; "slope" fits a linear trend over
+    # intermediate samples and exits as soon as the verdict is
+    # statistically clear.
+    strategy = "escalate"
+    # Number of intermediate memory samples per run ("slope" strategy).
+    slope_samples = 10
+    # If True, when a memory leak is detected re-measure each
+    # sub-phase registered on the failing LeakTest (setup / call /
+    # teardown) separately with reduced times, and append a per-phase
+    # verdict to the MemoryLeakError message. Narrows dispatcher-style
+    # targets down to the leaking branch without manual re-runs.
+    bisect_on_failure = False
+    # If True, when a memory leak is detected re-run a short loop
+    # under tracemalloc and append the top allocating Python
+    # tracebacks to the MemoryLeakError message. Runs on the failure
+    # path only, so the fast path is unaffected. C-level leaks (raw
+    # malloc) won't show up here.
+    trace_on_failure = False
+    # Wall-clock budget (seconds) for the memory checks of one test.
+    # When set, runs which no longer fit in the remaining budget are
+    # skipped and the test ends with InconclusiveError instead of
+    # escalating indefinitely; borderline tests may instead get up to
+    # 2x `retries` runs while the budget lasts. The
+    # PSLEAK_SESSION_BUDGET env var additionally caps the whole
+    # process. None = unlimited.
+    time_budget = None
     # Optional callable to free caches before starting measurement.
     trim_callback = None
     # Config object which tells which checkers to run.
     checkers = Checkers()
+    # GC generation swept by the gcgarbage checker. The default (2)
+    # runs full collections, which can cost seconds per test on huge
+    # heaps; 0 only sweeps objects created during the check window,
+    # which is usually all that's needed. See GCDebugger.
+    gc_generation = 2
+    # If True, aggregate fd / native-thread counters and memory
+    # (children_rss / children_vms metrics) over all child processes
+    # spawned by the tested function, with one batched scan per
+    # snapshot, and report children still alive after a call via
+    # UnclosedChildProcessError. Off by default: enumerating children
+    # costs a process-table scan per snapshot.
+    track_children = False
+    # If True (Linux only) also snapshot /proc/self/maps around each
+    # call, one compact hash per region, and report new anonymous
+    # mappings still mapped afterwards via UnclosedMmapRegionError,
+    # with their sizes. Localizes mmap_used growth which the memory
+    # check can only report as a scalar. Off by default: it adds one
+    # file read per snapshot.
+    track_mmap_regions = False
+    # If True run each leak test in a dedicated fork()ed worker
+    # process, isolating measurements from the rest of the test suite
+    # (POSIX only). Makes the suite safe to parallelize.
+    isolate = False
+    # If True run each _call_ntimes() measurement batch in a fork()ed
+    # copy-on-write child, so runs never contaminate each other (POSIX
+    # only). Since every run then starts from identical state, this
+    # pairs best with strategy="slope", which judges the trend within
+    # a single run.
+    isolate_runs = False
+    # If True, passed memory checks are recorded in an on-disk cache
+    # keyed on the target's code hash + effective options, and skipped
+    # on later runs as long as the target is unchanged. The cheap
+    # one-shot counter checks always run.
+    use_cache = False
+    # Where the result cache lives; the PSLEAK_CACHE env var overrides.
+    cache_path = ".psleak-cache.json"
+    # If set, append one JSON line per execute() call to this file
+    # (per-phase timings, per-run diffs, retries consumed). The
+    # PSLEAK_TELEMETRY env var can be used instead.
+    telemetry_path = None
+    # If set to a directory, record every intermediate memory sample
+    # into a preallocated ring buffer and, whether the test passes or
+    # fails, export them as <test id>.csv and <test id>.trace.json
+    # (Chrome trace-event format) in there. Shows the *shape* of
+    # growth (staircase leak vs one-time cache fill), so flaky
+    # MemoryLeakError failures can be diagnosed from CI artifacts.
+    # Under the escalate strategy the measurement loop is then chunked
+    # like the slope one, so intermediate samples exist at all. Note:
+    # with isolate_runs, samples taken in the forked child are lost.
+    samples_dir = None
+    # Max recorded samples per test; oldest are overwritten first.
+    samples_capacity = 4096
+    # If set to a directory, a failing memory check writes a
+    # <test id>.replay.json recipe there: the effective options, the
+    # per-run `times` sequence actually used, RNG-relevant env vars
+    # (PYTHONHASHSEED / PYTHONMALLOC) and any recorded samples.
+    # psleak.replay() / `python -m psleak replay` re-runs exactly that
+    # sequence, turning flaky CI failures into one targeted local
+    # reproduction. The PSLEAK_REPLAY env var can be used instead.
+    replay_dir = None
     # 0 = no messages; 1 = print diagnostics when memory increases.
     verbosity = 0
 
     __doc__ = __doc__
 
+    # fd baseline shared by all test instances of one class; see
+    # __init__ and _diff_fds()
+    _class_fds = None
+
     def __init__(self, *args, **kwargs):
         super().__init__(*args, **kwargs)
-        self._cached_fds = self._get_fds()
+        # On Linux the baseline is a cheap {fd: symlink target} dict;
+        # elsewhere it's the full (expensive) open_files() +
+        # net_connections() scan. unittest creates one instance per
+        # test method, so the baseline is snapshotted once per class
+        # rather than once per instance; _diff_fds() invalidates it
+        # when an fd check actually fails.
+        cls = type(self)
+        if cls.__dict__.get("_class_fds") is None:
+            cls._class_fds = (
+                self._fd_snapshot() if LINUX else self._get_fds()
+            )
+        self._cached_fds = cls._class_fds
+        self._telemetry = None
+        self._isolate_runs = self.isolate_runs
+        self._deadline = None
+        self._async_loop = None
+        self._ring = None
+        self._ring_ncalls = 0
+        # set by auto-generated tests to the underlying (pre-partial)
+        # function, so sibling tests exercising the same function with
+        # different arguments share one warmup and trim baselines
+        self._warm_group = None
+        self._shared_baseline = None
+        # {phase name: callable} registered via LeakTest setup /
+        # teardown; consumed by bisect_on_failure
+        self._bisect_phase_funs = {}
+        # (funs, labels) set by execute_matrix() for the duration of
+        # an interleaved argument sweep
+        self._matrix = None
+        # recipe dict set by replay(); pins options and `times`
+        self._replay = None
+        # `times` used by each measurement run, for replay recipes
+        self._run_times = []
         warm_caches()
 
     @classmethod
@@ -418,19 +1243,66 @@ class MemoryLeakTestCase(unittest.TestCase):
                 msg = f"{cls.__name__} already defines {test_name}"
                 raise RuntimeError(msg)
 
+            if entry.variants is not None:
+
+                def make_matrix_test(entry, test_name=test_name, name=name):
+                    def test(self):
+                        self.execute_matrix(
+                            entry.fun,
+                            entry.variants,
+                            **entry.execute_kwargs,
+                        )
+
+                    test.__name__ = test_name
+                    test.__qualname__ = test_name
+                    test.__doc__ = (
+                        f"Auto-generated leak sweep for {name}"
+                        f" ({len(entry.variants)} variants)"
+                    )
+                    return test
+
+                setattr(cls, test_name, make_matrix_test(entry))
+                continue
+
             fun = entry._make_callable()
+            base_fun = entry.fun
+            phases = {
+                "setup": entry.setup,
+                "call": fun,
+                "teardown": entry.teardown,
+            }
             execute_kwargs = dict(entry.execute_kwargs)
 
-            def make_test(fun, execute_kwargs, test_name=test_name, name=name):
+            def make_test(
+                fun,
+                base_fun,
+                phases,
+                execute_kwargs,
+                test_name=test_name,
+                name=name,
+            ):
                 def test(self):
-                    self.execute(fun, **execute_kwargs)
+                    # matrix-style suites call the same underlying
+                    # function with many argument variants; group them
+                    # so warmup runs once per function, not per test
+                    self._warm_group = base_fun
+                    self._bisect_phase_funs = phases
+                    try:
+                        self.execute(fun, **execute_kwargs)
+                    finally:
+                        self._warm_group = None
+                        self._bisect_phase_funs = {}
 
                 test.__name__ = test_name
                 test.__qualname__ = test_name
                 test.__doc__ = f"Auto-generated leak test for {name}"
                 return test
 
-            setattr(cls, test_name, make_test(fun, execute_kwargs))
+            setattr(
+                cls,
+                test_name,
+                make_test(fun, base_fun, phases, execute_kwargs),
+            )
 
     @classmethod
     def setUpClass(cls):
@@ -454,6 +1326,7 @@ class MemoryLeakTestCase(unittest.TestCase):
 
     def _trim_mem(self):
         """Release unused memory. Aims to stabilize memory measurements."""
+        started = time.monotonic()
         if self._trim_callback is not None:
             self._trim_callback()
 
@@ -485,9 +1358,41 @@ class MemoryLeakTestCase(unittest.TestCase):
         if hasattr(psutil, "heap_trim"):
             psutil.heap_trim()
 
+        if self._telemetry is not None:
+            self._telemetry.add_phase("trim", time.monotonic() - started)
+
+    def _use_call_trampoline(self):
+        """Whether the C repeat-call helper can replace the Python
+        measurement loop. Only safe when self.call() was not
+        overridden by a subclass.
+        """
+        return (
+            _psleak_ext is not None
+            and type(self).call is MemoryLeakTestCase.call
+        )
+
+    def _call_fun_ntimes(self, fun, times):
+        if self._use_call_trampoline():
+            _psleak_ext.call_ntimes(fun, times)
+        else:
+            for _ in range(times):
+                self.call(fun)
+
     def _warmup(self, fun, warmup_times):
-        for _ in range(warmup_times):
-            self.call(fun)
+        group = self._warm_group
+        if group is not None:
+            if group in _warmed_groups:
+                self._log(
+                    "skipping warmup (underlying function already warmed by a"
+                    " sibling test)",
+                    1,
+                )
+                return
+            _warmed_groups.add(group)
+        started = time.monotonic()
+        self._call_fun_ntimes(fun, warmup_times)
+        if self._telemetry is not None:
+            self._telemetry.add_phase("warmup", time.monotonic() - started)
 
     # --- getters
 
@@ -506,49 +1411,320 @@ class MemoryLeakTestCase(unittest.TestCase):
             pass
         return ls
 
-    def _get_counters(self, checkers):
-        # order matters
+    def _fd_snapshot(self):
+        """Return a {fd: symlink target} dict from /proc/self/fd.
+        Considerably cheaper than _get_fds(): one readdir + one
+        readlink per fd, no /proc/net parsing. Linux only.
+        """
         d = {}
-        if checkers.py_threads:
-            d["py_threads"] = (
-                threading.active_count(),
-                threading.enumerate(),
-            )
-        if POSIX and checkers.fds:
-            d["num_fds"] = (thisproc.num_fds(), self._cached_fds)
-        if WINDOWS and checkers.handles:
-            d["num_handles"] = (thisproc.num_handles(), self._cached_fds)
-        if checkers.c_threads:
-            d["c_threads"] = (thisproc.num_threads(), thisproc.threads())
-        if WINDOWS and checkers.memory:
-            d["heap_count"] = (psutil.heap_info().heap_count, [])
+        for fd in os.listdir("/proc/self/fd"):
+            try:
+                d[int(fd)] = os.readlink(f"/proc/self/fd/{fd}")
+            except OSError:
+                continue  # fd was closed in the meantime
         return d
 
-    def _get_mem(self):
-        mem = thisproc.memory_full_info()
-        heap_used = mmap_used = 0
-        if hasattr(psutil, "heap_info"):
-            heap = psutil.heap_info()
-            heap_used = heap.heap_used
-            mmap_used = heap.mmap_used
+    def _resolve_fds(self, fd_targets):
+        """Resolve a {fd: symlink target} dict into rich objects
+        suitable for UnclosedFdError extras. Sockets are resolved with
+        a single net_connections() call; regular files straight from
+        the symlink target; anything else (pipes, eventfds, ...) as a
+        plain descriptive string.
+        """
+        extras = []
+        sock_fds = {
+            fd
+            for fd, target in fd_targets.items()
+            if target.startswith("socket:")
+        }
+        if sock_fds:
+            try:
+                conns = thisproc.net_connections(kind="all")
+            except psutil.Error:
+                conns = []
+            extras.extend(x for x in conns if x.fd in sock_fds)
+        for fd, target in sorted(fd_targets.items()):
+            if fd in sock_fds:
+                continue
+            if target.startswith("/"):
+                extras.append(popenfile(path=target, fd=fd))
+            else:
+                extras.append(f"fd {fd} -> {target}")
+        return extras
+
+    def _diff_fds(self):
+        """Return rich info for the fds opened since the cached
+        baseline, and update the cache. On Linux only the fds that
+        actually changed are resolved (incremental); elsewhere this
+        falls back to a full _get_fds() rescan. Only called on failure.
+        """
+        # the per-class baseline (see __init__) no longer reflects
+        # reality: force the next instance to rescan
+        type(self)._class_fds = None
+        if isinstance(self._cached_fds, dict):
+            old = self._cached_fds
+            new = self._cached_fds = self._fd_snapshot()
+            changed = {
+                fd: target
+                for fd, target in new.items()
+                if old.get(fd) != target
+            }
+            return self._resolve_fds(changed)
+        before = self._cached_fds
+        after = self._cached_fds = self._get_fds()
+        return set(after) - set(before)
+
+    def _snap_counts(self, want_fds, want_threads):
+        """Return (num_fds, num_c_threads, child_pids, tids) in a
+        single pass. On Linux this is one readdir of /proc/self/fd +
+        one of /proc/self/task, instead of separate psutil calls which
+        each re-open and re-parse /proc/self/* files; `tids` is the
+        set of native thread ids from the latter readdir, used by
+        _diff_native_threads() to attribute failures. Counters which
+        are not wanted are not collected and returned as None. In
+        track_children mode the fd / thread counters also include the
+        children's totals and child_pids lists who contributed.
+        """
+        num_fds = num_threads = tids = None
+        done = False
+        if LINUX:
+            try:
+                if want_fds:
+                    num_fds = len(os.listdir("/proc/self/fd"))
+                if want_threads:
+                    tids = {int(x) for x in os.listdir("/proc/self/task")}
+                    num_threads = len(tids)
+            except OSError:
+                pass
+            else:
+                done = True
+        if not done:
+            if want_fds:
+                num_fds = thisproc.num_fds()
+            if want_threads:
+                num_threads = thisproc.num_threads()
+        if not self.track_children:
+            return (num_fds, num_threads, (), tids)
+        pids, child_fds, child_threads, _, _ = self._scan_children()
+        if want_fds:
+            num_fds += child_fds
+        if want_threads:
+            num_threads += child_threads
+        return (num_fds, num_threads, pids, tids)
+
+    def _diff_native_threads(self, tids_before, tids_after):
+        """Resolve rich info for the native threads involved in an
+        UnclosedNativeThreadError. thisproc.threads() parses
+        /proc/self/task/*/stat for every thread to get CPU times, so
+        it is only called here, on the failure path; when TID sets are
+        available (Linux) only the threads which appeared between the
+        two snapshots are reported.
+        """
+        try:
+            threads = thisproc.threads()
+        except psutil.Error:
+            return []
+        if tids_before is None or tids_after is None:
+            return threads
+        new = set(tids_after) - set(tids_before)
+        return [x for x in threads if x.id in new]
+
+    def _scan_children(self):
+        """One batched scan of all live (recursive) child processes,
+        aggregating their fd / native-thread counts and memory. On
+        Linux each child costs two readdirs + one statm read instead
+        of the several psutil calls per child which would multiply the
+        sampling cost. Children dying mid-scan are skipped. Returns
+        (pids, num_fds, num_threads, rss, vms). track_children only.
+        """
+        pids = []
+        num_fds = num_threads = rss = vms = 0
+        try:
+            children = thisproc.children(recursive=True)
+        except psutil.Error:
+            children = []
+        for child in children:
+            pid = child.pid
+            if LINUX:
+                try:
+                    nfds = len(os.listdir(f"/proc/{pid}/fd"))
+                    nthreads = len(os.listdir(f"/proc/{pid}/task"))
+                    with open(f"/proc/{pid}/statm") as f:
+                        size, resident = f.read().split()[:2]
+                except OSError:
+                    continue  # died mid-scan
+                pagesize = os.sysconf("SC_PAGE_SIZE")
+                crss = int(resident) * pagesize
+                cvms = int(size) * pagesize
+            else:
+                try:
+                    with child.oneshot():
+                        nfds = (
+                            child.num_fds()
+                            if POSIX
+                            else child.num_handles()
+                        )
+                        nthreads = child.num_threads()
+                        mem = child.memory_info()
+                except psutil.Error:
+                    continue
+                crss = mem.rss
+                cvms = mem.vms
+            pids.append(pid)
+            num_fds += nfds
+            num_threads += nthreads
+            rss += crss
+            vms += cvms
+        return (tuple(pids), num_fds, num_threads, rss, vms)
+
+    def _snap_mmap_regions(self):
+        """Compact /proc/self/maps snapshot for the mmap_regions
+        checker: one integer hash per region, computed over its
+        address range + permissions, so the hot path costs a single
+        file read and keeps no region details around. Returns
+        (count, hashes); _diff_mmap_regions() resolves the details on
+        the failure path. track_mmap_regions only, Linux only.
+        """
+        hashes = set()
+        with open("/proc/self/maps", "rb") as f:
+            for line in f:
+                addr, perms, _ = line.split(b" ", 2)
+                hashes.add(hash(addr + perms))
+        return (len(hashes), frozenset(hashes))
+
+    def _diff_mmap_regions(self, hashes_before):
+        """Failure-path resolver for the mmap_regions checker: re-read
+        /proc/self/maps in full and describe the anonymous regions
+        which were not part of the pre-call snapshot, with their
+        sizes. File-backed mappings are skipped: they come and go with
+        imports / dlopen() and are not what mmap leak debugging is
+        after.
+        """
+        out = []
+        with open("/proc/self/maps", "rb") as f:
+            for line in f:
+                fields = line.split(None, 5)
+                addr, perms = fields[0], fields[1]
+                if hash(addr + perms) in hashes_before:
+                    continue
+                path = fields[5].strip() if len(fields) > 5 else b""
+                if path and not path.startswith((b"[anon", b"/dev/zero")):
+                    # file-backed, [heap], [stack], ... /dev/zero is
+                    # kept: it's how MAP_SHARED | MAP_ANONYMOUS (and
+                    # Python's own mmap(-1, n)) shows up in maps
+                    continue
+                start, _, end = addr.partition(b"-")
+                size = int(end, 16) - int(start, 16)
+                label = (path or b"anon").decode()
+                out.append(
+                    f"{addr.decode()} {perms.decode()} {label}"
+                    f" ({size} bytes)"
+                )
+        return out
+
+    def _handle_counts(self):
+        """Per-type handle counts ({object type name: count}) captured
+        by the C accelerator in a single native snapshot, or None if
+        unavailable. Windows only.
+        """
+        global _native_handles_broken  # noqa: PLW0603
+        if _psleak_ext is None or _native_handles_broken:
+            return None
+        if not hasattr(_psleak_ext, "handle_counts"):  # non-Windows build
+            return None
+        try:
+            return _psleak_ext.handle_counts()
+        except OSError:
+            _native_handles_broken = True
+            return None
+
+    def _snap_handles(self):
+        counts = self._handle_counts()
+        if counts is None:
+            # fall back to the total-only psutil counter; extras are
+            # then resolved by _diff_fds() on failure
+            return (thisproc.num_handles(), self._cached_fds)
+        return (sum(counts.values()), counts)
+
+    def _diff_handle_types(self, before, after):
+        """Summarize per-type handle growth as e.g. "Event: +2"."""
+        return [
+            f"{name}: +{after[name] - before.get(name, 0)}"
+            for name in sorted(after)
+            if after[name] - before.get(name, 0) > 0
+        ]
+
+    def _get_counters(self, plan):
+        snap = self._snap_counts(
+            want_fds=plan.want_fds,
+            want_threads=plan.want_threads,
+        )
+        return {name: count(self, snap) for name, count, _, _ in plan.entries}
+
+    def _sample_mem_native(self):
+        """Get all 5 memory metrics in a single pass via the optional C
+        accelerator (reads /proc/self/smaps_rollup + statm +
+        mallinfo2(), Linux only). Return None if unavailable, in which
+        case the caller falls back to psutil, which is considerably
+        slower (memory_full_info() walks the whole /proc/self/smaps).
+        """
+        global _native_sampler_broken  # noqa: PLW0603
+        if _psleak_ext is None or _native_sampler_broken:
+            return None
+        if not hasattr(_psleak_ext, "sample_mem"):  # non-Linux build
+            return None
+        try:
+            heap, mmap, uss, rss, vms = _psleak_ext.sample_mem()
+        except OSError:
+            # e.g. no /proc/self/smaps_rollup on old kernels; don't
+            # retry on every sample
+            _native_sampler_broken = True
+            return None
         return {
-            "heap": heap_used,
-            "mmap": mmap_used,
-            "uss": getattr(mem, "uss", 0),
-            "rss": mem.rss,
-            "vms": mem.vms,
+            "heap": heap,
+            "mmap": mmap,
+            "uss": uss,
+            "rss": rss,
+            "vms": vms,
         }
 
+    def _get_mem(self):
+        d = self._sample_mem_native()
+        if d is None:
+            mem = thisproc.memory_full_info()
+            heap_used = mmap_used = 0
+            if hasattr(psutil, "heap_info"):
+                heap = psutil.heap_info()
+                heap_used = heap.heap_used
+                mmap_used = heap.mmap_used
+            d = {
+                "heap": heap_used,
+                "mmap": mmap_used,
+                "uss": getattr(mem, "uss", 0),
+                "rss": mem.rss,
+                "vms": mem.vms,
+            }
+        counters = _load_interpose()
+        if counters:
+            # exact outstanding byte counts maintained by the
+            # LD_PRELOAD interposer, see psleak_interpose.c
+            d["heap_exact"] = counters[0].value
+            d["mmap_exact"] = counters[1].value
+        if self.track_children:
+            _, _, _, rss, vms = self._scan_children()
+            d["children_rss"] = rss
+            d["children_vms"] = vms
+        return d
+
     # --- checkers
 
-    def _check_counters(self, fun, checkers):
-        before = self._get_counters(checkers)
+    def _check_counters(self, fun, plan):
+        before = self._get_counters(plan)
         self.call(fun)
-        after = self._get_counters(checkers)
+        after = self._get_counters(plan)
 
-        for what, (count_before, extras_before) in before.items():
-            count_after = after[what][0]
-            extras_after = after[what][1]
+        for what, (count_before, token_before) in before.items():
+            count_after, token_after = after[what]
             diff = count_after - count_before
 
             if diff < 0:
@@ -559,51 +1735,239 @@ class MemoryLeakTestCase(unittest.TestCase):
                 self._log(msg, 0)
 
             elif diff > 0:
-                if what in {"num_fds", "num_handles"}:
-                    # fetch fds and update cache only in case of failure
-                    extras_after = self._cached_fds = self._get_fds()
-
-                extras = set(extras_after) - set(extras_before)
-                mapping = {
-                    "num_fds": UnclosedFdError,
-                    "num_handles": UnclosedHandleError,
-                    "heap_count": UnclosedHeapCreateError,
-                    "py_threads": UnclosedPythonThreadError,
-                    "c_threads": UnclosedNativeThreadError,
-                }
-                exc = mapping.get(what)
-                if exc is None:
-                    raise ValueError(what)
+                # expensive resource enumeration happens here only, on
+                # the failure path (see _CheckerPlan)
+                extras = plan.extras[what](self, token_before, token_after)
+                exc = plan.exceptions[what]
                 raise exc(diff, qualname(fun), extras=extras)
 
     def _call_ntimes(self, fun, times):
         """Get memory samples before and after calling fun repeatedly,
-        and return the diffs as a dict.
+        and return the diffs as a dict. With isolate_runs each batch
+        runs in a fork()ed copy-on-write child which reports its own
+        diffs over a pipe and exits, so no state created by the loop
+        (caches, fds, allocator pools) survives into later runs.
         """
-        self._trim_mem()
-        mem1 = self._get_mem()
+        if self._isolate_runs:
+            return self._fork_worker(
+                functools.partial(self._measure_ntimes, fun, times)
+            )
+        return self._measure_ntimes(fun, times)
+
+    def _measure_ntimes(self, fun, times):
+        if self._ring is not None:
+            # chunked like the slope strategy, so the recorded samples
+            # capture the shape of the growth, not just its endpoints
+            _, samples = self._sample_ntimes(fun, times, self.slope_samples)
+            self._trim_mem()
+            final = self._get_mem()
+            self._record_sample(final)
+            return {k: final[k] - samples[0][k] for k in samples[0]}
+
+        if self._shared_baseline is not None:
+            # for grouped tests the previous run ended with a trim +
+            # sample and nothing ran in between: reuse it instead of
+            # trimming (heap_trim() + full gc.collect()) again
+            mem1 = self._shared_baseline
+            self._shared_baseline = None
+        else:
+            self._trim_mem()
+            mem1 = self._get_mem()
 
-        for _ in range(times):
-            self.call(fun)
+        started = time.monotonic()
+        self._call_fun_ntimes(fun, times)
+        if self._telemetry is not None:
+            self._telemetry.add_phase("measure", time.monotonic() - started)
 
         self._trim_mem()
         mem2 = self._get_mem()
+        if self._warm_group is not None:
+            self._shared_baseline = mem2
 
         diffs = {k: mem2[k] - mem1[k] for k in mem1}
         return diffs
 
-    def _check_mem(self, fun, times, retries, tolerance):
-        prev = {}
-        messages = []
+    def _measure_matrix(self, funs, times):
+        """One interleaved measurement pass over all sweep variants:
+        each variant runs `times` calls back to back with a memory
+        sample in between, so the whole sweep pays a single
+        _trim_mem() (heap_trim() + full gc.collect()) instead of one
+        per variant. Growth is attributed to a variant from the
+        samples bracketing its chunk. Returns one diffs dict per
+        variant.
+        """
+        self._trim_mem()
+        prev = self._get_mem()
+        self._record_sample(prev)
+        out = []
+        started = time.monotonic()
+        for fun in funs:
+            self._call_fun_ntimes(fun, times)
+            cur = self._get_mem()
+            self._record_sample(cur, times)
+            out.append({k: cur[k] - prev[k] for k in prev})
+            prev = cur
+        if self._telemetry is not None:
+            self._telemetry.add_phase("measure", time.monotonic() - started)
+        return out
+
+    def _calibrate_tolerance(self, times):
+        """Measure a no-op function through the full _call_ntimes()
+        pipeline a few times and derive per-metric tolerances from the
+        observed allocator jitter (2x the worst positive diff seen).
+        The result is cached for the rest of the process, like
+        warm_caches() / _emit_warnings().
+        """
+        global _calibrated_tolerances  # noqa: PLW0603
+        if _calibrated_tolerances is None:
+
+            def noop():
+                pass
+
+            runs = [
+                self._call_ntimes(noop, times)
+                for _ in range(self.calibration_runs)
+            ]
+            _calibrated_tolerances = {
+                k: max(max(run[k] for run in runs), 0) * 2 for k in runs[0]
+            }
+            self._log(
+                f"calibrated tolerances: {_calibrated_tolerances}", 1
+            )
+        return dict(_calibrated_tolerances)
+
+    def _normalize_tolerance(self, tolerance):
+        """Return tolerance as a per-metric dict."""
         if isinstance(tolerance, dict):
-            tolerances = tolerance
-        else:
-            t = 0 if tolerance is None else tolerance
-            tolerances = dict.fromkeys(self._get_mem(), t)
+            return tolerance
+        t = 0 if tolerance is None else tolerance
+        return dict.fromkeys(self._get_mem(), t)
+
+    def _sample_ntimes(self, fun, times, nsamples):
+        """Call fun() `times` times, sampling memory every
+        times / nsamples calls. Return (xs, samples) where xs[i] is the
+        number of calls made when samples[i] was taken.
+        """
+        self._trim_mem()
+        interval = max(1, times // nsamples)
+        xs = [0]
+        samples = [self._get_mem()]
+        self._record_sample(samples[0])
+        ncalls = 0
+        while ncalls < times:
+            chunk = min(interval, times - ncalls)
+            self._call_fun_ntimes(fun, chunk)
+            ncalls += chunk
+            xs.append(ncalls)
+            samples.append(self._get_mem())
+            self._record_sample(samples[-1], chunk)
+        return (xs, samples)
+
+    def _record_sample(self, mem, ncalls=0):
+        """Feed one memory sample into the ring buffer, if recording
+        is enabled (see samples_dir). `ncalls` advances the cumulative
+        call counter across runs.
+        """
+        if self._ring is not None:
+            self._ring_ncalls += ncalls
+            self._ring.add(self._ring_ncalls, mem)
+
+    def _check_mem_slope(self, fun, times, retries, tolerance):
+        """Alternative to the escalation loop in _check_mem(): fit a
+        linear trend over intermediate memory samples and exit as soon
+        as the slope's confidence interval includes zero (no leak), or
+        as soon as the slope is decisively positive on two consecutive
+        runs (leak). Typically converges in 2-3 runs instead of ~10,
+        without ever escalating `times`.
+        """
+        tolerances = self._normalize_tolerance(tolerance)
+        messages = []
+        suspects = None
+        deadline = self._deadline
+        for idx in range(1, retries + 1):
+            self._run_times.append(times)
+            started = time.monotonic()
+            xs, samples = self._sample_ntimes(fun, times, self.slope_samples)
+            run_secs = time.monotonic() - started
+            diffs = {k: samples[-1][k] - samples[0][k] for k in samples[0]}
+            if self._telemetry is not None:
+                self._telemetry.add_run(diffs, times)
+            leaks = {k: v for k, v in diffs.items() if v > 0}
+
+            growing = set()
+            for k in samples[0]:
+                ys = [s[k] for s in samples]
+                slope, stderr = fit_slope(xs, ys)
+                # per-call growth budget derived from the absolute
+                # tolerance; 2 * stderr ~= 95% confidence interval
+                allowed = tolerances.get(k, 0) / times
+                if slope - 2 * stderr > allowed:
+                    growing.add(k)
+
+            if leaks:
+                line = format_run_line(idx, leaks, times)
+                if growing:
+                    line += f" (growing: {', '.join(sorted(growing))})"
+                messages.append(line)
+                self._log(line, 1)
+
+            if not growing:
+                if idx > 1 and leaks:
+                    self._log(
+                        "Memory stabilized (growth slope is within noise)", 1
+                    )
+                return
+            if suspects is not None and growing & suspects:
+                break  # decisively positive on two consecutive runs
+            suspects = growing
+            # runs don't escalate here, so the next one costs the same
+            if (
+                deadline is not None
+                and idx < retries
+                and not deadline.allows(run_secs)
+            ):
+                msg = (
+                    f"inconclusive: time budget exhausted after {idx} runs"
+                    + "\n".join(messages)
+                )
+                raise InconclusiveError(msg)
+
+        msg = "memory growth slope is decisively positive" + "\n".join(
+            messages
+        )
+        if self.trace_on_failure:
+            msg += self._trace_allocations(fun, times)
+        raise MemoryLeakError(msg)
+
+    def _check_mem(self, fun, times, retries, tolerance, strategy="escalate"):
+        if strategy == "slope":
+            return self._check_mem_slope(fun, times, retries, tolerance)
+
+        stats = _RunStats()
+        messages = []
+        tolerances = self._normalize_tolerance(tolerance)
+        deadline = self._deadline
+        # a budget both caps runaway tests and lets borderline ones
+        # retry more often than usual, as long as time remains
+        max_runs = retries if deadline is None else retries * 2
+        times_seq = None
+        if self._replay is not None:
+            # re-run the recorded sequence exactly, no escalation drift
+            times_seq = self._replay["times_seq"]
+            max_runs = len(times_seq)
 
         increase = int(times / 2)  # 50%
-        for idx in range(1, retries + 1):
+        idx = 0  # retries=0 means fail without measuring
+        for idx in range(1, max_runs + 1):
+            if times_seq is not None:
+                times = times_seq[idx - 1]
+            self._run_times.append(times)
+            started = time.monotonic()
             diffs = self._call_ntimes(fun, times)
+            run_secs = time.monotonic() - started
+            if self._telemetry is not None:
+                self._telemetry.add_run(diffs, times)
+            stats.add(diffs)
             leaks = {k: v for k, v in diffs.items() if v > 0}
 
             if leaks:
@@ -613,9 +1977,10 @@ class MemoryLeakTestCase(unittest.TestCase):
 
             # stable means:
             # * any growth is within tolerance, OR
-            # * growth has stopped (no increase vs prev)
+            # * growth has stopped (the trend over *all* runs so far is
+            #   no longer positive)
             stable = all(
-                diffs[k] <= tolerances.get(k, 0) or diffs[k] <= prev.get(k, 0)
+                diffs[k] <= tolerances.get(k, 0) or stats.trend(k) <= 0
                 for k in diffs
             )
 
@@ -626,13 +1991,173 @@ class MemoryLeakTestCase(unittest.TestCase):
                     )
                 return
 
-            prev = diffs
             times += increase
+            # the next run does 50% more calls: predict its duration
+            # and stop here if it no longer fits in the budget
+            if (
+                deadline is not None
+                and idx < max_runs
+                and not deadline.allows(run_secs * 1.5)
+            ):
+                msg = (
+                    f"inconclusive: time budget exhausted after {idx} runs"
+                    + "\n".join(messages)
+                )
+                raise InconclusiveError(msg)
+
+        msg = f"memory kept increasing after {idx} runs" + "\n".join(messages)
+        if self.trace_on_failure:
+            msg += self._trace_allocations(fun, times)
+        err = MemoryLeakError(msg)
+        err.stats = stats.summary()
+        raise err
+
+    def _check_mem_matrix(self, funs, labels, times, retries, tolerance):
+        """Escalation loop for argument sweeps (execute_matrix()): one
+        interleaved _measure_matrix() pass per run, with per-variant
+        streaming statistics deciding stability. A run only escalates
+        while at least one variant's whole-history trend is positive,
+        and the final MemoryLeakError names the leaking variants.
+        """
+        stats = [_RunStats() for _ in funs]
+        messages = []
+        tolerances = self._normalize_tolerance(tolerance)
+        deadline = self._deadline
+        max_runs = retries if deadline is None else retries * 2
 
-        msg = f"memory kept increasing after {retries} runs" + "\n".join(
-            messages
+        increase = int(times / 2)  # 50%
+        # retries=0 means fail without measuring; every variant is a
+        # suspect then
+        idx = 0
+        unstable = list(range(len(funs)))
+        for idx in range(1, max_runs + 1):
+            self._run_times.append(times)
+            started = time.monotonic()
+            all_diffs = self._measure_matrix(funs, times)
+            run_secs = time.monotonic() - started
+
+            unstable = []
+            for i, diffs in enumerate(all_diffs):
+                stats[i].add(diffs)
+                if self._telemetry is not None:
+                    self._telemetry.add_run(diffs, times)
+                leaks = {k: v for k, v in diffs.items() if v > 0}
+                if leaks:
+                    line = (
+                        format_run_line(idx, leaks, times) + f" [{labels[i]}]"
+                    )
+                    messages.append(line)
+                    self._log(line, 1)
+                stable = all(
+                    diffs[k] <= tolerances.get(k, 0)
+                    or stats[i].trend(k) <= 0
+                    for k in diffs
+                )
+                if not stable:
+                    unstable.append(i)
+
+            if not unstable:
+                if idx > 1:
+                    self._log(
+                        "Memory stabilized for all variants (no further"
+                        " growth detected)",
+                        1,
+                    )
+                return
+
+            times += increase
+            if (
+                deadline is not None
+                and idx < max_runs
+                and not deadline.allows(run_secs * 1.5)
+            ):
+                msg = (
+                    f"inconclusive: time budget exhausted after {idx} runs"
+                    + "\n".join(messages)
+                )
+                raise InconclusiveError(msg)
+
+        culprits = ", ".join(labels[i] for i in unstable)
+        msg = (
+            f"memory kept increasing after {idx} runs for"
+            f" {len(unstable)}/{len(funs)} variants ({culprits})"
+            + "\n".join(messages)
         )
-        raise MemoryLeakError(msg)
+        if self.trace_on_failure:
+            msg += self._trace_allocations(funs[unstable[0]], times)
+        err = MemoryLeakError(msg)
+        err.stats = {labels[i]: stats[i].summary() for i in unstable}
+        raise err
+
+    def _trace_allocations(self, fun, times, limit=5):
+        """Re-run a short loop under tracemalloc and return a report of
+        the top allocating Python tracebacks. Only used on the failure
+        path (see trace_on_failure), so the cost doesn't matter much.
+        """
+        times = min(times, 100)
+        tracemalloc.start(10)
+        try:
+            before = tracemalloc.take_snapshot()
+            for _ in range(times):
+                self.call(fun)
+            after = tracemalloc.take_snapshot()
+        finally:
+            tracemalloc.stop()
+
+        filters = [
+            tracemalloc.Filter(False, tracemalloc.__file__),
+            tracemalloc.Filter(False, linecache.__file__),
+        ]
+        before = before.filter_traces(filters)
+        after = after.filter_traces(filters)
+        lines = ["", f"Top allocating tracebacks ({times} calls):"]
+        for stat in after.compare_to(before, "traceback")[:limit]:
+            if stat.size_diff <= 0:
+                continue
+            lines.append(f"+{stat.size_diff}B in {stat.count_diff} blocks:")
+            lines.extend("  " + x for x in stat.traceback.format())
+        return "\n".join(lines)
+
+    def _bisect_report(self, times, retries, tolerance, strategy):
+        """Re-measure each registered sub-phase (LeakTest setup / call /
+        teardown) in isolation and return a per-phase LEAKS / ok report.
+        Only used on the failure path (see bisect_on_failure), with
+        reduced times / retries since a crude verdict is enough to
+        point at the culprit.
+        """
+        if not self.bisect_on_failure or not self._bisect_phase_funs:
+            return ""
+        times = max(10, times // 4)
+        retries = max(2, retries // 2)
+        lines = ["", f"Bisecting phases ({times} calls each):"]
+        # the phase re-runs must not recurse into tracing / bisection,
+        # nor pollute the `times` sequence a replay recipe would
+        # record for the main measurement loop (see _write_replay())
+        saved = self.trace_on_failure
+        saved_run_times = list(self._run_times)
+        self.trace_on_failure = False
+        try:
+            for phase, fun in self._bisect_phase_funs.items():
+                if fun is None:
+                    continue
+                try:
+                    self._check_mem(
+                        fun,
+                        times=times,
+                        retries=retries,
+                        tolerance=tolerance,
+                        strategy=strategy,
+                    )
+                except MemoryLeakError:
+                    lines.append(f"  {phase}: LEAKS")
+                except InconclusiveError:
+                    lines.append(f"  {phase}: inconclusive")
+                else:
+                    lines.append(f"  {phase}: ok")
+        finally:
+            self.trace_on_failure = saved
+            self._run_times = saved_run_times
+        return "\n".join(lines)
 
     def _validate_opts(
         self, warmup_times, times, retries, tolerance, trim_callback
@@ -675,6 +2200,142 @@ class MemoryLeakTestCase(unittest.TestCase):
     def call(self, fun):
         return fun()
 
+    def _cache_key(self, fun, opts):
+        target_hash = _hash_target(fun)
+        if target_hash is None:
+            return None
+        return target_hash + "|" + repr(opts)
+
+    def _run_checks(
+        self, fun, warmup_times, times, retries, tolerance, checkers, strategy
+    ):
+        plan = _compile_checkers(
+            checkers,
+            self.track_children,
+            bool(LINUX and self.track_mmap_regions),
+        )
+
+        # run check counters
+        if plan.gcgarbage:
+            with GCDebugger(generation=self.gc_generation) as gcdbg:
+                self._check_counters(fun, plan)
+            gcdbg.check(fun)
+        else:
+            self._check_counters(fun, plan)
+
+        # run memory checks
+        if plan.memory:
+            if self._matrix is not None:
+                # interleaved argument sweep: shares one warmup and
+                # one trim per run across all variants; bypasses the
+                # result cache (the composite closure would not hash
+                # distinctly per sweep)
+                funs, labels = self._matrix
+                if self.auto_tolerance and not tolerance:
+                    tolerance = self._calibrate_tolerance(times)
+                self._warmup(funs[0], warmup_times)
+                for f in funs[1:]:
+                    # one call is enough for sibling variants: the
+                    # underlying function is already warm
+                    self.call(f)
+                self._check_mem_matrix(
+                    funs, labels, times, retries, tolerance
+                )
+                return
+            cache = key = None
+            if self.use_cache:
+                path = os.environ.get("PSLEAK_CACHE") or self.cache_path
+                cache = _ResultCache(path)
+                opts = (warmup_times, times, retries, tolerance, strategy)
+                key = self._cache_key(fun, opts)
+                if key is not None and cache.has(key):
+                    self._log(
+                        f"cache hit for {qualname(fun)!r}; skipping memory"
+                        " checks",
+                        1,
+                    )
+                    return
+            if self.auto_tolerance and not tolerance:
+                tolerance = self._calibrate_tolerance(times)
+            self._warmup(fun, warmup_times)
+            try:
+                self._check_mem(
+                    fun,
+                    times=times,
+                    retries=retries,
+                    tolerance=tolerance,
+                    strategy=strategy,
+                )
+            except MemoryLeakError as err:
+                report = self._bisect_report(
+                    times, retries, tolerance, strategy
+                )
+                if report:
+                    exc = MemoryLeakError(str(err) + report)
+                    exc.stats = err.stats
+                    raise exc from None
+                raise
+            if key is not None:
+                cache.add(key)
+
+    def _fork_worker(self, workfun):
+        """Run workfun() in a fork()ed worker process and return its
+        (picklable) result in the parent, re-raising whatever the
+        worker raised. POSIX only.
+        """
+
+        def dump_exc(file, err):
+            try:
+                payload = pickle.dumps(("exc", err))
+                pickle.loads(payload)  # make sure it round-trips
+            except Exception:
+                payload = pickle.dumps(
+                    ("exc", Error(f"{qualname(type(err))}: {err}"))
+                )
+            file.write(payload)
+
+        rfd, wfd = os.pipe()
+        pid = os.fork()
+        if pid == 0:  # worker
+            exit_code = 1
+            try:
+                os.close(rfd)
+                with os.fdopen(wfd, "wb") as file:
+                    try:
+                        payload = pickle.dumps(("ok", workfun()))
+                    except BaseException as err:  # noqa: BLE001
+                        dump_exc(file, err)
+                    else:
+                        file.write(payload)
+                exit_code = 0
+            finally:
+                os._exit(exit_code)
+
+        # parent
+        os.close(wfd)
+        with os.fdopen(rfd, "rb") as file:
+            try:
+                kind, payload = pickle.load(file)
+            except EOFError:
+                kind, payload = (None, None)
+        _, status = os.waitpid(pid, 0)
+        if kind == "exc":
+            raise payload
+        if kind is None:
+            msg = f"forked worker process died (wait status={status})"
+            raise Error(msg)
+        return payload
+
+    def _run_isolated(self, fun, **kwargs):
+        """Run the full check pipeline in a dedicated single-purpose
+        worker process fork()ed off for this test only, so that the
+        measurements never see heap / fd / thread interference from
+        other tests running in the same interpreter (e.g. via
+        pytest-xdist). The worker reports its outcome over a pipe and
+        exits. POSIX only.
+        """
+        self._fork_worker(functools.partial(self._run_checks, fun, **kwargs))
+
     def execute(
         self,
         fun,
@@ -685,6 +2346,10 @@ class MemoryLeakTestCase(unittest.TestCase):
         tolerance=None,
         trim_callback=None,
         checkers=None,
+        isolate=None,
+        isolate_runs=None,
+        strategy=None,
+        time_budget=None,
     ):
         """Run a full leak test on a callable. If specified, the
         optional arguments override the class attributes with the same
@@ -700,36 +2365,225 @@ class MemoryLeakTestCase(unittest.TestCase):
         trim_callback = (
             trim_callback if trim_callback is not None else self.trim_callback
         )
+        isolate = isolate if isolate is not None else self.isolate
+        isolate_runs = (
+            isolate_runs if isolate_runs is not None else self.isolate_runs
+        )
+        strategy = strategy if strategy is not None else self.strategy
+        time_budget = (
+            time_budget if time_budget is not None else self.time_budget
+        )
+        if self._replay is not None:
+            # pin every effective option to what the recorded failing
+            # run used, regardless of class attrs and kwargs
+            opts = self._replay["opts"]
+            warmup_times = opts["warmup_times"]
+            times = opts["times"]
+            retries = opts["retries"]
+            tolerance = opts["tolerance"]
+            strategy = opts["strategy"]
 
         self._validate_opts(
             warmup_times, times, retries, tolerance, trim_callback
         )
+        if (isolate or isolate_runs) and not POSIX:
+            msg = "isolate / isolate_runs are only supported on POSIX"
+            raise ValueError(msg)
+        if strategy not in {"escalate", "slope"}:
+            msg = f"invalid strategy {strategy!r}"
+            raise ValueError(msg)
+        if time_budget is not None:
+            assert_isinstance("time_budget", time_budget, (int, float))
+            if time_budget <= 0:
+                msg = f"time_budget must be > 0 (got {time_budget})"
+                raise ValueError(msg)
 
         if checkers.memory and os.environ.get("PYTHONMALLOC", "") != "malloc":
             msg = "PYTHONMALLOC=malloc was not set"
             raise unittest.SkipTest(msg)
 
-        _emit_warnings()
+        _emit_warnings(isolate=isolate)
 
         if args:
             fun = functools.partial(fun, *args)
 
         self._trim_callback = trim_callback
-
-        # run check counters
-        if checkers.gcgarbage:
-            with GCDebugger() as gcdbg:
-                self._check_counters(fun, checkers)
-            gcdbg.check(fun)
+        self._isolate_runs = isolate_runs
+        self._deadline = _get_deadline(time_budget)
+        # a baseline can only be reused between back-to-back runs of
+        # the same execute() call, never across tests
+        self._shared_baseline = None
+        self._run_times = []
+
+        path = self.telemetry_path or os.environ.get("PSLEAK_TELEMETRY")
+        self._telemetry = _Telemetry(path, self, fun) if path else None
+        if self.samples_dir:
+            self._ring = _SampleRing(self.samples_capacity)
+            self._ring_ncalls = 0
+
+        kwargs = dict(
+            warmup_times=warmup_times,
+            times=times,
+            retries=retries,
+            tolerance=tolerance,
+            checkers=checkers,
+            strategy=strategy,
+        )
+        try:
+            if isolate:
+                self._run_isolated(fun, **kwargs)
+            else:
+                self._run_checks(fun, **kwargs)
+        except BaseException as err:
+            if self._telemetry is not None:
+                self._telemetry.write(type(err).__name__)
+            if isinstance(err, MemoryLeakError):
+                self._write_replay(fun, kwargs)
+            raise
         else:
-            self._check_counters(fun, checkers)
+            if self._telemetry is not None:
+                self._telemetry.write("pass")
+        finally:
+            self._telemetry = None
+            self._deadline = None
+            if self._ring is not None:
+                self._export_samples()
+                self._ring = None
+            self._shared_baseline = None
+
+    def _artifact_path(self, directory, suffix):
+        """Path for a per-test output file inside `directory` (created
+        if needed), with the test id sanitized into a file name.
+        """
+        os.makedirs(directory, exist_ok=True)
+        name = self.id()
+        base = "".join(c if c.isalnum() or c in "._-" else "_" for c in name)
+        return os.path.join(directory, base + suffix)
+
+    def _export_samples(self):
+        if self._ring.total == 0:
+            return
+        self._ring.export_csv(self._artifact_path(self.samples_dir, ".csv"))
+        self._ring.export_trace(
+            self._artifact_path(self.samples_dir, ".trace.json"), self.id()
+        )
 
-        # run memory checks
-        if checkers.memory:
-            self._warmup(fun, warmup_times)
-            self._check_mem(
-                fun, times=times, retries=retries, tolerance=tolerance
+    def _write_replay(self, fun, opts):
+        """Serialize the failing run's full recipe (effective options,
+        per-run `times` sequence, RNG-relevant env vars, recorded
+        samples) so replay() can re-run exactly that sequence. No-op
+        unless replay_dir (or PSLEAK_REPLAY) is set; never re-recorded
+        while already replaying.
+        """
+        replay_dir = self.replay_dir or os.environ.get("PSLEAK_REPLAY")
+        if not replay_dir or self._replay is not None:
+            return
+        rec = {
+            "test": self.id(),
+            "fun": qualname(fun),
+            "timestamp": time.time(),
+            "opts": {
+                "warmup_times": opts["warmup_times"],
+                "times": opts["times"],
+                "retries": opts["retries"],
+                "tolerance": opts["tolerance"],
+                "strategy": opts["strategy"],
+            },
+            "times_seq": list(self._run_times),
+            "env": {
+                name: os.environ.get(name)
+                for name in ("PYTHONHASHSEED", "PYTHONMALLOC")
+            },
+            "samples": (
+                self._ring.rows() if self._ring is not None else None
+            ),
+        }
+        path = self._artifact_path(replay_dir, ".replay.json")
+        with open(path, "w") as file:
+            json.dump(rec, file)
+        self._log(f"replay recipe written to {path}", 0)
+
+    def _drive_coro(self, loop, corofun, *args):
+        return loop.run_until_complete(corofun(*args))
+
+    def execute_async(self, fun, *args, **kwargs):
+        """Run a full leak test on a coroutine function. One long-lived
+        event loop is created upfront and reused to drive the coroutine
+        through warmup and every measured call, so that per-call loop
+        setup / teardown allocations never pollute the heap deltas.
+        Pending tasks and unclosed transports left on the loop are
+        reported as UnclosedAsyncResourceError (see
+        Checkers.async_tasks). Accepts the same optional arguments as
+        execute().
+        """
+        if not asyncio.iscoroutinefunction(fun):
+            msg = f"{qualname(fun)!r} is not a coroutine function"
+            raise TypeError(msg)
+        isolate = kwargs.get("isolate")
+        isolate = isolate if isolate is not None else self.isolate
+        isolate_runs = kwargs.get("isolate_runs")
+        isolate_runs = (
+            isolate_runs if isolate_runs is not None else self.isolate_runs
+        )
+        if isolate or isolate_runs:
+            # an event loop must not be driven across fork()
+            msg = "isolate / isolate_runs are incompatible with execute_async"
+            raise ValueError(msg)
+
+        loop = asyncio.new_event_loop()
+        self._async_loop = loop
+        try:
+            self.execute(
+                functools.partial(self._drive_coro, loop, fun),
+                *args,
+                **kwargs,
             )
+        finally:
+            self._async_loop = None
+            try:
+                loop.run_until_complete(loop.shutdown_asyncgens())
+            finally:
+                loop.close()
+
+    def execute_matrix(self, fun, variants, **kwargs):
+        """Run one leak-test session over many argument variants of
+        `fun` (see LeakTest.matrix()). All variants are interleaved in
+        a single measurement loop with a memory sample between chunks:
+        the whole sweep shares one warmup and pays one _trim_mem() per
+        run instead of per variant, and growth is attributed
+        per-variant from the interleaved samples. Accepts the same
+        optional arguments as execute(), except that only the
+        "escalate" strategy is supported.
+        """
+        variants = tuple(
+            args if isinstance(args, tuple) else (args,) for args in variants
+        )
+        if not variants:
+            msg = "'variants' must be a non-empty sequence"
+            raise ValueError(msg)
+        strategy = kwargs.get("strategy")
+        strategy = strategy if strategy is not None else self.strategy
+        if strategy == "slope":
+            msg = "matrix sweeps only support the 'escalate' strategy"
+            raise ValueError(msg)
+
+        base = qualname(fun)
+        funs = []
+        labels = []
+        for args in variants:
+            funs.append(functools.partial(fun, *args) if args else fun)
+            labels.append(f"{base}({', '.join(map(repr, args))})")
+
+        def sweep():
+            # what the one-shot counter checks run: every variant once
+            for f in funs:
+                self.call(f)
+
+        self._matrix = (funs, labels)
+        try:
+            self.execute(sweep, **kwargs)
+        finally:
+            self._matrix = None
 
     def execute_w_exc(self, exc, fun, *args, **kwargs):
         """Run MemoryLeakTestCase.execute() expecting fun() to raise
@@ -752,3 +2606,77 @@ class MemoryLeakTestCase(unittest.TestCase):
             fun = functools.partial(fun, *args)
 
         self.execute(call, **kwargs)
+
+
+# --- replay harness
+
+
+def _iter_suite(suite):
+    for item in suite:
+        if isinstance(item, unittest.TestSuite):
+            yield from _iter_suite(item)
+        else:
+            yield item
+
+
+def replay(path, samples_dir=None, verbosity=1):
+    """Re-run the exact measurement sequence recorded in a replay
+    recipe file (see MemoryLeakTestCase.replay_dir): the test is
+    loaded by id, the effective options and the per-run `times`
+    sequence of the failing run are pinned (no escalation drift), and
+    sample recording is enabled (into the recipe's directory unless
+    `samples_dir` says otherwise) so the growth shape can be
+    inspected. Returns the unittest.TestResult. Also available as
+    `python -m psleak replay <recipe>`.
+    """
+    with open(path) as file:
+        recipe = json.load(file)
+    hashseed = recipe["env"].get("PYTHONHASHSEED")
+    if hashseed and os.environ.get("PYTHONHASHSEED") != hashseed:
+        msg = (
+            f"recipe was recorded with PYTHONHASHSEED={hashseed}; set it to"
+            " reproduce the same hash randomization"
+        )
+        warnings.warn(msg, RuntimeWarning, stacklevel=2)
+    if samples_dir is None:
+        samples_dir = os.path.dirname(os.path.abspath(path))
+    suite = unittest.defaultTestLoader.loadTestsFromName(recipe["test"])
+    for test in _iter_suite(suite):
+        if isinstance(test, MemoryLeakTestCase):
+            test._replay = recipe
+            test.samples_dir = samples_dir
+            test.verbosity = max(test.verbosity, verbosity)
+    result = unittest.TestResult()
+    suite.run(result)
+    return result
+
+
+def _main():
+    parser = argparse.ArgumentParser(prog="psleak")
+    sub = parser.add_subparsers(dest="command", required=True)
+    rep = sub.add_parser(
+        "replay",
+        help="re-run a memory check failure recorded via replay_dir",
+    )
+    rep.add_argument("recipe", help="path to a .replay.json file")
+    rep.add_argument(
+        "--samples-dir",
+        default=None,
+        help="where to export the recorded memory samples (default:"
+        " next to the recipe)",
+    )
+    args = parser.parse_args()
+    result = replay(args.recipe, samples_dir=args.samples_dir)
+    for _test, tb in result.failures + result.errors:
+        print(tb)  # noqa: T201
+    sys.exit(0 if result.wasSuccessful() else 1)
+
+
+if __name__ == "__main__":
+    # `python -m psleak` executes this file as __main__, a separate
+    # module object from the `psleak` the loaded tests subclass:
+    # delegate to the canonical import so replay()'s isinstance
+    # check against MemoryLeakTestCase actually matches
+    import psleak
+
+    psleak._main()
@@ -0,0 +1,159 @@
+// Copyright (c) 2025, Giampaolo Rodola. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// LD_PRELOAD interposer counting outstanding heap and mmap bytes.
+// Build it with "make build-interpose" and run the test suite with:
+//
+//     LD_PRELOAD=./psleak_interpose.so python3 -m pytest ...
+//
+// psleak.py picks the counters up via ctypes and adds exact
+// "heap_exact" / "mmap_exact" metrics to _get_mem(), turning the
+// heuristic before/after heap deltas into exact outstanding-byte
+// counts. Linux / glibc only.
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+// Outstanding bytes; signed so that frees of allocations made before
+// this library was initialized can't wrap the counters around.
+atomic_long psleak_interpose_heap_bytes = 0;
+atomic_long psleak_interpose_mmap_bytes = 0;
+
+static void *(*real_malloc)(size_t) = NULL;
+static void (*real_free)(void *) = NULL;
+static void *(*real_calloc)(size_t, size_t) = NULL;
+static void *(*real_realloc)(void *, size_t) = NULL;
+static void *(*real_mmap)(void *, size_t, int, int, int, off_t) = NULL;
+static int (*real_munmap)(void *, size_t) = NULL;
+
+// dlsym() itself may call calloc(); serve those early allocations from
+// a static buffer (never freed, see is_bootstrap_ptr()).
+static char bootstrap_buf[8192];
+static size_t bootstrap_used = 0;
+static int initializing = 0;
+
+
+static int
+is_bootstrap_ptr(void *ptr) {
+    return (char *)ptr >= bootstrap_buf
+           && (char *)ptr < bootstrap_buf + sizeof(bootstrap_buf);
+}
+
+
+static void
+init_real(void) {
+    if (real_malloc != NULL)
+        return;
+    initializing = 1;
+    real_malloc = dlsym(RTLD_NEXT, "malloc");
+    real_free = dlsym(RTLD_NEXT, "free");
+    real_calloc = dlsym(RTLD_NEXT, "calloc");
+    real_realloc = dlsym(RTLD_NEXT, "realloc");
+    real_mmap = dlsym(RTLD_NEXT, "mmap");
+    real_munmap = dlsym(RTLD_NEXT, "munmap");
+    initializing = 0;
+}
+
+
+void *
+malloc(size_t size) {
+    void *ptr;
+
+    init_real();
+    ptr = real_malloc(size);
+    if (ptr != NULL)
+        atomic_fetch_add(
+            &psleak_interpose_heap_bytes, (long)malloc_usable_size(ptr)
+        );
+    return ptr;
+}
+
+
+void *
+calloc(size_t nmemb, size_t size) {
+    void *ptr;
+
+    if (initializing || real_calloc == NULL) {
+        size_t total = nmemb * size;
+        if (real_calloc != NULL && !initializing) {
+            init_real();
+        }
+        if (initializing) {
+            // bump-allocate from the static buffer (zeroed by the
+            // loader); dlsym() needs only a few small blocks
+            if (bootstrap_used + total > sizeof(bootstrap_buf))
+                return NULL;
+            ptr = bootstrap_buf + bootstrap_used;
+            bootstrap_used += total;
+            return ptr;
+        }
+        init_real();
+    }
+    ptr = real_calloc(nmemb, size);
+    if (ptr != NULL)
+        atomic_fetch_add(
+            &psleak_interpose_heap_bytes, (long)malloc_usable_size(ptr)
+        );
+    return ptr;
+}
+
+
+void *
+realloc(void *old, size_t size) {
+    void *ptr;
+    long old_size = 0;
+
+    init_real();
+    if (old != NULL && !is_bootstrap_ptr(old))
+        old_size = (long)malloc_usable_size(old);
+    ptr = real_realloc(old, size);
+    if (ptr != NULL) {
+        atomic_fetch_sub(&psleak_interpose_heap_bytes, old_size);
+        atomic_fetch_add(
+            &psleak_interpose_heap_bytes, (long)malloc_usable_size(ptr)
+        );
+    }
+    return ptr;
+}
+
+
+void
+free(void *ptr) {
+    if (ptr == NULL || is_bootstrap_ptr(ptr))
+        return;
+    init_real();
+    atomic_fetch_sub(
+        &psleak_interpose_heap_bytes, (long)malloc_usable_size(ptr)
+    );
+    real_free(ptr);
+}
+
+
+void *
+mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    void *ptr;
+
+    init_real();
+    ptr = real_mmap(addr, length, prot, flags, fd, offset);
+    if (ptr != MAP_FAILED)
+        atomic_fetch_add(&psleak_interpose_mmap_bytes, (long)length);
+    return ptr;
+}
+
+
+int
+munmap(void *addr, size_t length) {
+    int ret;
+
+    init_real();
+    ret = real_munmap(addr, length);
+    if (ret == 0)
+        atomic_fetch_sub(&psleak_interpose_mmap_bytes, (long)length);
+    return ret;
+}
@@ -0,0 +1,161 @@
+# Copyright (c) 2025, Giampaolo Rodola. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Sweep psleak's detection sensitivity against a calibrated leak
+corpus: functions leaking an exact number of bytes per call (via
+test_ext.malloc), an fd per call, or a native thread per call, plus
+their clean (leak-free) counterparts. For each configuration it reports
+detection rate, false-positive rate and wall time, so that times /
+retries / tolerance can be tuned empirically. Run via
+"make bench-sensitivity". Requires "make build" first.
+"""
+
+import argparse
+import functools
+import os
+import time
+
+import test_ext as cext
+from psutil import POSIX
+
+from psleak import Checkers
+from psleak import Error
+from psleak import MemoryLeakTestCase
+
+# bytes leaked per call by the malloc corpus
+SIZES = [1, 16, 256, 4096, 1024 * 1024]
+
+# (times, retries, tolerance) configurations swept by default
+CONFIGS = [
+    (20, 3, 0),
+    (50, 5, 0),
+    (200, 10, 0),
+    (200, 10, 4096),
+]
+
+
+class BenchCase(MemoryLeakTestCase):
+    verbosity = 0
+    warmup_times = 2
+
+
+def clean_malloc(size):
+    ptr = cext.malloc(size)
+    cext.free(ptr)
+
+
+def leak_fd():
+    os.open(os.devnull, os.O_RDONLY)
+
+
+def clean_fd():
+    os.close(os.open(os.devnull, os.O_RDONLY))
+
+
+def build_corpus():
+    """Return a list of (name, fun, cleanup, checkers, leaky) tuples."""
+    corpus = []
+    for size in SIZES:
+        mem = Checkers.only("memory")
+        corpus.append((
+            f"malloc-{size}b",
+            functools.partial(cext.malloc, size),
+            None,
+            mem,
+            True,
+        ))
+        corpus.append((
+            f"malloc-free-{size}b",
+            functools.partial(clean_malloc, size),
+            None,
+            mem,
+            False,
+        ))
+    if POSIX:
+        fds = Checkers.only("fds")
+        corpus.append(("open-fd", leak_fd, None, fds, True))
+        corpus.append(("open-close-fd", clean_fd, None, fds, False))
+
+    threads = Checkers.only("c_threads")
+    ptrs = []
+
+    def leak_thread():
+        ptrs.append(cext.start_native_thread())
+
+    def stop_threads():
+        while ptrs:
+            cext.stop_native_thread(ptrs.pop())
+
+    corpus.append(("native-thread", leak_thread, stop_threads, threads, True))
+    return corpus
+
+
+def bench_one(fun, checkers, times, retries, tolerance):
+    """Run one corpus entry; return (detected, elapsed seconds)."""
+    case = BenchCase()
+    started = time.monotonic()
+    try:
+        case.execute(
+            fun,
+            times=times,
+            retries=retries,
+            tolerance=tolerance,
+            checkers=checkers,
+        )
+    except Error:
+        detected = True
+    else:
+        detected = False
+    return (detected, time.monotonic() - started)
+
+
+def sweep(configs):
+    corpus = build_corpus()
+    header = (
+        f"{'config':<28} {'detected':>9} {'false-pos':>10} {'seconds':>8}"
+    )
+    print(header)  # noqa: T201
+    print("-" * len(header))  # noqa: T201
+    for times, retries, tolerance in configs:
+        nleaky = ndetected = nclean = nfalse = 0
+        elapsed = 0.0
+        for _name, fun, cleanup, checkers, leaky in corpus:
+            detected, secs = bench_one(
+                fun, checkers, times, retries, tolerance
+            )
+            elapsed += secs
+            if cleanup is not None:
+                cleanup()
+            if leaky:
+                nleaky += 1
+                ndetected += detected
+            else:
+                nclean += 1
+                nfalse += detected
+        cfg = f"times={times} retries={retries} tol={tolerance}"
+        detect = f"{ndetected}/{nleaky}"
+        false = f"{nfalse}/{nclean}"
+        line = f"{cfg:<28} {detect:>9} {false:>10} {elapsed:>8.1f}"
+        print(line)  # noqa: T201
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--times", type=int)
+    parser.add_argument("--retries", type=int)
+    parser.add_argument("--tolerance", type=int, default=0)
+    args = parser.parse_args()
+    if args.times or args.retries:
+        configs = [(
+            args.times or BenchCase.times,
+            args.retries or BenchCase.retries,
+            args.tolerance,
+        )]
+    else:
+        configs = CONFIGS
+    sweep(configs)
+
+
+if __name__ == "__main__":
+    main()
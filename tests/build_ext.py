@@ -2,6 +2,7 @@
 # Use of this source code is governed by a BSD-style license that can be
 # found in the LICENSE file.
 
+from psutil import LINUX
 from psutil import POSIX
 from psutil import WINDOWS
 from setuptools import Extension
@@ -13,6 +14,8 @@ if POSIX:
     macros.append(("PSLEAK_POSIX", 1))
 if WINDOWS:
     macros.append(("PSLEAK_WINDOWS", 1))
+if LINUX:
+    macros.append(("PSLEAK_LINUX", 1))
 
 setup(
     name="test_ext",
@@ -21,6 +24,12 @@ setup(
             "test_ext",
             ["tests/test_ext.c"],
             define_macros=macros,
-        )
+        ),
+        # optional C accelerator used by psleak itself
+        Extension(
+            "_psleak_ext",
+            ["_psleak_ext.c"],
+            define_macros=macros,
+        ),
     ],
 )
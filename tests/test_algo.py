@@ -4,12 +4,19 @@
 
 """Test memory leak detection heurisics."""
 
+import json
+import os
+import subprocess
+import sys
+import time
 import unittest
 
 import pytest
 
+import psleak
 from psleak import MemoryLeakError
 from psleak import MemoryLeakTestCase
+from psleak import fit_slope
 
 
 class DummyMemLeakTest(MemoryLeakTestCase):
@@ -93,6 +100,17 @@ class TestMemleakDetectionAlgo(unittest.TestCase):
         with pytest.raises(MemoryLeakError):
             t.execute(noop, retries=len(diffs))
 
+    def test_invalid_strategy(self):
+        t = DummyMemLeakTest([])
+        with pytest.raises(ValueError, match="invalid strategy"):
+            t.execute(noop, strategy="bogus")
+
+    def test_zero_retries(self):
+        # valid per _validate_opts: fail right away, measure nothing
+        t = DummyMemLeakTest([])
+        with pytest.raises(MemoryLeakError, match="after 0 runs"):
+            t.execute(noop, retries=0)
+
     def test_metric_disappears(self):
         diffs = [
             {"heap": 1024, "uss": 8192, "rss": 4096, "vms": 0, "mmap": 0},
@@ -101,3 +119,691 @@ class TestMemleakDetectionAlgo(unittest.TestCase):
         t = DummyMemLeakTest(diffs)
         t.execute(noop, retries=len(diffs))
         assert "no further growth" in t.printed()
+
+
+# --- streaming run statistics
+
+
+class TestRunStats:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_accumulators(self):
+        stats = psleak._RunStats()
+        stats.add({"heap": 1000})
+        assert stats.trend("heap") == float("inf")  # no trend yet
+        stats.add({"heap": 3000})
+        assert stats.trend("heap") == 2000
+        s = stats.summary()["heap"]
+        assert s["runs"] == 2
+        assert s["mean"] == 2000
+        assert s["min"] == 1000
+        assert s["slope"] == 2000
+
+    def test_lucky_low_sample_not_stable(self):
+        # under the old previous-run-only rule the third run (1900 <=
+        # 2000) would have been called stable; the whole-history trend
+        # is still clearly positive
+        diffs = [self.mkdiff(1000), self.mkdiff(2000), self.mkdiff(1900)]
+        t = DummyMemLeakTest(diffs)
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, retries=3)
+
+    def test_stats_exposed_on_error(self):
+        diffs = [self.mkdiff(1000), self.mkdiff(3000)]
+        t = DummyMemLeakTest(diffs)
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(noop, retries=2)
+        stats = exc.value.stats
+        assert stats["heap"]["runs"] == 2
+        assert stats["heap"]["mean"] == 2000
+        assert stats["heap"]["slope"] == 2000
+        assert stats["uss"]["min"] == 0
+
+
+# --- slope strategy
+
+
+class DummySlopeTest(MemoryLeakTestCase):
+    strategy = "slope"
+
+    def __init__(self, sample_seq):
+        super().__init__("runTest")
+        self._sample_seq = iter(sample_seq)
+
+    def _sample_ntimes(self, fun, times, nsamples):
+        return next(self._sample_seq)
+
+    def call(self, fun):
+        return None
+
+
+def make_run(heaps):
+    xs = list(range(len(heaps)))
+    samples = [
+        {"heap": h, "uss": 0, "rss": 0, "vms": 0, "mmap": 0} for h in heaps
+    ]
+    return (xs, samples)
+
+
+class TestSlopeStrategy(unittest.TestCase):
+
+    def test_fit_slope(self):
+        slope, stderr = fit_slope([0, 1, 2, 3], [0, 2, 4, 6])
+        assert slope == 2.0
+        assert stderr == 0.0
+        slope, _ = fit_slope([0, 1, 2, 3], [6, 4, 2, 0])
+        assert slope == -2.0
+        # degenerate: a single x value
+        assert fit_slope([1, 1], [0, 10]) == (0.0, 0.0)
+
+    def test_leak(self):
+        # steady growth on two consecutive runs: decisively positive
+        runs = [make_run([i * 100 for i in range(11)]) for _ in range(3)]
+        t = DummySlopeTest(runs)
+        with pytest.raises(MemoryLeakError, match="decisively positive"):
+            t.execute(noop)
+
+    def test_noise(self):
+        # jittery but trendless samples: CI includes zero, 1 run enough
+        heaps = [0, 300, -200, 100, -300, 200, 0, -100, 300, -200, 0]
+        t = DummySlopeTest([make_run(heaps)])
+        t.execute(noop)
+
+    def test_flat(self):
+        t = DummySlopeTest([make_run([1000] * 11)])
+        t.execute(noop)
+
+    def test_growth_within_tolerance(self):
+        runs = [make_run([i * 100 for i in range(11)]) for _ in range(3)]
+        t = DummySlopeTest(runs)
+        # total growth is 1000 bytes over `times` calls; a tolerance
+        # covering it means the per-call budget absorbs the slope
+        t.execute(noop, times=10, tolerance=2000)
+
+
+# --- auto tolerance
+
+
+class DummyAutoTolTest(DummyMemLeakTest):
+    auto_tolerance = True
+    calibration_runs = 2
+
+
+class TestAutoTolerance(unittest.TestCase):
+
+    def setUp(self):
+        psleak._calibrated_tolerances = None
+
+    tearDown = setUp
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_jitter_absorbed(self):
+        # 2 calibration runs showing 1000b of heap jitter derive a
+        # 2000b heap tolerance, which absorbs the 1500b test growth
+        diffs = [self.mkdiff(1000), self.mkdiff(1000), self.mkdiff(1500)]
+        t = DummyAutoTolTest(diffs)
+        t.execute(noop, retries=1)
+        assert psleak._calibrated_tolerances["heap"] == 2000
+
+    def test_leak_still_detected(self):
+        diffs = [self.mkdiff(1000), self.mkdiff(1000)]
+        diffs += [self.mkdiff(5000), self.mkdiff(7500)]
+        t = DummyAutoTolTest(diffs)
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, retries=2)
+
+    def test_calibrated_once_per_process(self):
+        diffs = [self.mkdiff(1000), self.mkdiff(1000), self.mkdiff(0)]
+        DummyAutoTolTest(diffs).execute(noop, retries=1)
+        # second test case must reuse the cached calibration: only one
+        # diff is consumed
+        DummyAutoTolTest([self.mkdiff(0)]).execute(noop, retries=1)
+
+    def test_explicit_tolerance_wins(self):
+        # no calibration diffs are consumed when a tolerance is given
+        t = DummyAutoTolTest([self.mkdiff(100)])
+        t.execute(noop, retries=1, tolerance=200)
+        assert psleak._calibrated_tolerances is None
+
+
+# --- telemetry
+
+
+class TestTelemetry:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def read_rec(self, path):
+        lines = path.read_text().splitlines()
+        assert len(lines) == 1
+        return json.loads(lines[0])
+
+    def test_pass_outcome(self, tmp_path):
+        path = tmp_path / "telemetry.jsonl"
+        t = DummyMemLeakTest([self.mkdiff(0)])
+        t.telemetry_path = str(path)
+        t.execute(noop, retries=1)
+        rec = self.read_rec(path)
+        assert rec["outcome"] == "pass"
+        assert rec["fun"] == "noop"
+        assert len(rec["runs"]) == 1
+        assert rec["runs"][0]["diffs"]["heap"] == 0
+        assert "warmup" in rec["phases"]
+        assert rec["elapsed"] >= 0
+
+    def test_failure_outcome(self, tmp_path):
+        path = tmp_path / "telemetry.jsonl"
+        t = DummyMemLeakTest([self.mkdiff(1000), self.mkdiff(2000)])
+        t.telemetry_path = str(path)
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, retries=2)
+        rec = self.read_rec(path)
+        assert rec["outcome"] == "MemoryLeakError"
+        assert len(rec["runs"]) == 2
+
+    def test_env_var(self, tmp_path, monkeypatch):
+        path = tmp_path / "telemetry.jsonl"
+        monkeypatch.setenv("PSLEAK_TELEMETRY", str(path))
+        t = DummyMemLeakTest([self.mkdiff(0)])
+        t.execute(noop, retries=1)
+        assert self.read_rec(path)["outcome"] == "pass"
+
+    def test_disabled_by_default(self, tmp_path):
+        t = DummyMemLeakTest([self.mkdiff(0)])
+        t.execute(noop, retries=1)
+        assert list(tmp_path.iterdir()) == []
+
+
+# --- result cache
+
+
+class TestResultCache:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def make_test(self, diffs, path):
+        t = DummyMemLeakTest(diffs)
+        t.use_cache = True
+        t.cache_path = path
+        return t
+
+    def test_hash_target(self):
+        import functools
+
+        assert psleak._hash_target(noop) == psleak._hash_target(noop)
+        p1 = functools.partial(noop)
+        p2 = functools.partial(noop, 1)
+        assert psleak._hash_target(p1) != psleak._hash_target(p2)
+
+    def test_hit_skips_memory_checks(self, tmp_path):
+        path = str(tmp_path / "cache.json")
+        self.make_test([self.mkdiff(0)], path).execute(noop, retries=1)
+        # cache hit: no diffs are consumed, so an empty sequence is fine
+        self.make_test([], path).execute(noop, retries=1)
+
+    def test_option_change_invalidates(self, tmp_path):
+        path = str(tmp_path / "cache.json")
+        self.make_test([self.mkdiff(0)], path).execute(noop, retries=1)
+        # different `times` produces a different key: diffs consumed
+        t = self.make_test([self.mkdiff(0)], path)
+        t.execute(noop, retries=1, times=7)
+        with pytest.raises(StopIteration):
+            next(t._diffs_seq)
+
+    def test_failure_not_cached(self, tmp_path):
+        path = str(tmp_path / "cache.json")
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]
+        with pytest.raises(MemoryLeakError):
+            self.make_test(diffs, path).execute(noop, retries=2)
+        with pytest.raises(MemoryLeakError):
+            self.make_test(diffs, path).execute(noop, retries=2)
+
+    def test_disabled_by_default(self, tmp_path):
+        t = DummyMemLeakTest([self.mkdiff(0)])
+        t.cache_path = str(tmp_path / "cache.json")
+        t.execute(noop, retries=1)
+        assert not os.path.exists(t.cache_path)
+
+
+# --- time budget
+
+
+class DummySlowTest(DummyMemLeakTest):
+    run_secs = 0.02
+
+    def _call_ntimes(self, fun, times):
+        time.sleep(self.run_secs)
+        return super()._call_ntimes(fun, times)
+
+
+class TestTimeBudget:
+
+    def setup_method(self):
+        psleak._session_deadline = None
+
+    teardown_method = setup_method
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_inconclusive_on_budget_exhaustion(self):
+        # each run takes ~20ms; a 25ms budget can't fit a second
+        # (predicted ~30ms) run: distinct inconclusive outcome
+        diffs = [self.mkdiff(1000), self.mkdiff(2000), self.mkdiff(3000)]
+        t = DummySlowTest(diffs)
+        with pytest.raises(psleak.InconclusiveError, match="time budget"):
+            t.execute(noop, retries=3, time_budget=0.025)
+
+    def test_borderline_gets_extra_runs(self):
+        # with a generous budget an unstable test may use up to
+        # 2 * retries runs before the leak verdict
+        diffs = [self.mkdiff((i + 1) * 1000) for i in range(4)]
+        t = DummyMemLeakTest(diffs)
+        with pytest.raises(MemoryLeakError, match="after 4 runs"):
+            t.execute(noop, retries=2, time_budget=60)
+
+    def test_no_budget_unchanged(self):
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]
+        t = DummyMemLeakTest(diffs)
+        with pytest.raises(MemoryLeakError, match="after 2 runs"):
+            t.execute(noop, retries=2)
+
+    def test_session_budget_env_var(self, monkeypatch):
+        monkeypatch.setenv("PSLEAK_SESSION_BUDGET", "0.0001")
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]
+        t = DummyMemLeakTest(diffs)
+        with pytest.raises(psleak.InconclusiveError):
+            t.execute(noop, retries=2)
+
+    def test_invalid_budget(self):
+        t = DummyMemLeakTest([])
+        with pytest.raises(ValueError, match="time_budget"):
+            t.execute(noop, time_budget=0)
+
+
+# --- tracemalloc attribution
+
+
+class DummyTraceTest(DummyMemLeakTest):
+    trace_on_failure = True
+
+    def call(self, fun):
+        return fun()
+
+
+class TestTraceOnFailure:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_traceback_appended(self):
+        holder = []
+
+        def leaky():
+            holder.append([0] * 100)
+
+        t = DummyTraceTest([self.mkdiff(1000), self.mkdiff(2000)])
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(leaky, retries=2)
+        msg = str(exc.value)
+        assert "Top allocating tracebacks" in msg
+        assert "test_algo.py" in msg
+
+    def test_disabled_by_default(self):
+        t = DummyMemLeakTest([self.mkdiff(1000), self.mkdiff(2000)])
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(noop, retries=2)
+        assert "tracebacks" not in str(exc.value)
+
+
+# --- matrix sweeps
+
+
+class DummyMatrixTest(MemoryLeakTestCase):
+    warmup_times = 0
+
+    def __init__(self, mems):
+        super().__init__("runTest")
+        self._mems = iter(mems)  # sequence of _get_mem() returns
+        self.chunks = []  # (fun, times) per _call_fun_ntimes()
+        self.trims = 0
+
+    def _trim_mem(self):
+        self.trims += 1
+
+    def _get_mem(self):
+        return next(self._mems)
+
+    def _call_fun_ntimes(self, fun, times):
+        self.chunks.append((fun, times))
+
+    def call(self, fun):
+        return None
+
+
+class TestMatrixSweep:
+
+    def mkmem(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_leaking_variant_attributed(self):
+        mems = [self.mkmem(0)]  # consumed by _normalize_tolerance()
+        # run 1: variant 1 grows by 1000, variant 2 is flat
+        mems += [self.mkmem(0), self.mkmem(1000), self.mkmem(1000)]
+        # run 2: variant 1 grows by 2000, variant 2 is flat
+        mems += [self.mkmem(0), self.mkmem(2000), self.mkmem(2000)]
+        t = DummyMatrixTest(mems)
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute_matrix(noop, [(1,), (2,)], times=100, retries=2)
+        msg = str(exc.value)
+        assert "1/2 variants" in msg
+        assert "noop(1)" in msg
+        assert "noop(2)" not in msg.split("\n")[0]
+        assert list(exc.value.stats) == ["noop(1)"]
+
+    def test_one_trim_per_run(self):
+        mems = [self.mkmem(0)]
+        mems += [self.mkmem(0), self.mkmem(1000), self.mkmem(1000)]
+        mems += [self.mkmem(0), self.mkmem(2000), self.mkmem(2000)]
+        t = DummyMatrixTest(mems)
+        with pytest.raises(MemoryLeakError):
+            t.execute_matrix(noop, [(1,), (2,)], times=100, retries=2)
+        # 2 runs, 3 variant chunks measured per run, 2 trims total
+        # (the warmup chunk runs 0 times here)
+        assert t.trims == 2
+        assert [times for _, times in t.chunks] == [0, 100, 100, 150, 150]
+
+    def test_all_variants_stable(self):
+        mems = [self.mkmem(0)]
+        mems += [self.mkmem(0), self.mkmem(0), self.mkmem(0)]
+        t = DummyMatrixTest(mems)
+        t.execute_matrix(noop, [(1,), (2,)], times=100, retries=2)
+
+    def test_bare_values_as_single_arg(self):
+        mems = [self.mkmem(0)]
+        mems += [self.mkmem(0), self.mkmem(0), self.mkmem(0)]
+        t = DummyMatrixTest(mems)
+        t.execute_matrix(noop, [1, 2], times=100, retries=2)
+
+    def test_zero_retries(self):
+        # fail right away, measure nothing, blame every variant
+        t = DummyMatrixTest([self.mkmem(0)])  # tolerance sample only
+        with pytest.raises(MemoryLeakError, match="after 0 runs") as exc:
+            t.execute_matrix(noop, [(1,), (2,)], times=100, retries=0)
+        assert "2/2 variants" in str(exc.value)
+
+    def test_validation(self):
+        t = DummyMatrixTest([])
+        with pytest.raises(ValueError, match="non-empty"):
+            t.execute_matrix(noop, [])
+        with pytest.raises(ValueError, match="escalate"):
+            t.execute_matrix(noop, [(1,)], strategy="slope")
+        with pytest.raises(ValueError, match="non-empty"):
+            psleak.LeakTest.matrix(noop, [])
+
+
+# --- replay harness
+
+
+class DummyReplayTest(DummyMemLeakTest):
+    def __init__(self, diffs_seq):
+        super().__init__(diffs_seq)
+        self.times_seen = []
+
+    def _call_ntimes(self, fun, times):
+        self.times_seen.append(times)
+        return super()._call_ntimes(fun, times)
+
+
+class _ReplayableTest(MemoryLeakTestCase):
+    """Target loaded by name in TestReplay.test_entry_point; the
+    leading underscore keeps pytest from collecting it directly.
+    """
+
+    times_seen = []
+
+    def _call_ntimes(self, fun, times):
+        type(self).times_seen.append(times)
+        heap = 1000 * len(self.times_seen)
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def call(self, fun):
+        return None
+
+    def test_leak(self):
+        self.execute(noop)
+
+
+class TestReplay:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def mkrecipe(self, **kwargs):
+        recipe = {
+            "test": "tests.test_algo._ReplayableTest.test_leak",
+            "fun": "noop",
+            "opts": {
+                "warmup_times": 0,
+                "times": 10,
+                "retries": 2,
+                "tolerance": 0,
+                "strategy": "escalate",
+            },
+            "times_seq": [10, 15],
+            "env": {},
+        }
+        recipe.update(kwargs)
+        return recipe
+
+    def test_recipe_written_on_failure(self, tmp_path):
+        t = DummyMemLeakTest([self.mkdiff(1000), self.mkdiff(2000)])
+        t.replay_dir = str(tmp_path)
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, times=100, retries=2)
+        (path,) = tmp_path.glob("*.replay.json")
+        rec = json.loads(path.read_text())
+        assert rec["fun"] == "noop"
+        assert rec["opts"]["times"] == 100
+        assert rec["opts"]["retries"] == 2
+        assert rec["opts"]["strategy"] == "escalate"
+        assert rec["times_seq"] == [100, 150]  # 50% escalation
+        assert "PYTHONHASHSEED" in rec["env"]
+
+    def test_not_written_on_pass(self, tmp_path):
+        t = DummyMemLeakTest([self.mkdiff(0)])
+        t.replay_dir = str(tmp_path)
+        t.execute(noop, retries=1)
+        assert list(tmp_path.iterdir()) == []
+
+    def test_replay_pins_options_and_sequence(self):
+        # the recorded sequence wins over class attrs, kwargs and the
+        # escalation rule
+        diffs = [self.mkdiff((i + 1) * 1000) for i in range(3)]
+        t = DummyReplayTest(diffs)
+        t._replay = self.mkrecipe(times_seq=[100, 150, 225])
+        with pytest.raises(MemoryLeakError, match="after 3 runs"):
+            t.execute(noop, times=5000, retries=50)
+        assert t.times_seen == [100, 150, 225]
+
+    def test_entry_point(self, tmp_path):
+        path = tmp_path / "leak.replay.json"
+        path.write_text(json.dumps(self.mkrecipe()))
+        _ReplayableTest.times_seen = []
+        result = psleak.replay(str(path), verbosity=0)
+        assert not result.wasSuccessful()  # the leak was reproduced
+        assert len(result.failures) == 1
+        assert "memory kept increasing" in result.failures[0][1]
+        assert _ReplayableTest.times_seen == [10, 15]
+
+    def test_cli_entry_point(self, tmp_path):
+        # `python -m psleak` executes psleak.py as __main__; the
+        # pinning must still apply to tests subclassing the
+        # canonically imported psleak.MemoryLeakTestCase (without it
+        # the leak escalates for the default 10 retries instead)
+        path = tmp_path / "leak.replay.json"
+        path.write_text(json.dumps(self.mkrecipe()))
+        proc = subprocess.run(
+            [sys.executable, "-m", "psleak", "replay", str(path)],
+            capture_output=True,
+            text=True,
+            check=False,
+            cwd=os.path.dirname(psleak.__file__),
+        )
+        assert proc.returncode == 1, proc.stderr
+        assert "memory kept increasing after 2 runs" in proc.stdout
+
+    def test_no_rerecord_while_replaying(self, tmp_path):
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]
+        t = DummyMemLeakTest(diffs)
+        t.replay_dir = str(tmp_path)
+        t._replay = self.mkrecipe()
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop)
+        assert list(tmp_path.iterdir()) == []
+
+
+# --- phase bisection
+
+
+class DummyBisectTest(DummyMemLeakTest):
+    bisect_on_failure = True
+
+
+class TestBisectOnFailure:
+
+    def mkdiff(self, heap):
+        return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def test_phase_verdicts_appended(self):
+        # main measurement leaks, then each phase is re-measured:
+        # setup stable, call leaking, teardown stable
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]  # main run
+        diffs += [self.mkdiff(0)]  # setup
+        diffs += [self.mkdiff(1000), self.mkdiff(2000)]  # call
+        diffs += [self.mkdiff(0)]  # teardown
+        t = DummyBisectTest(diffs)
+        t._bisect_phase_funs = {
+            "setup": noop,
+            "call": noop,
+            "teardown": noop,
+        }
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(noop, retries=2)
+        msg = str(exc.value)
+        assert "Bisecting phases" in msg
+        assert "setup: ok" in msg
+        assert "call: LEAKS" in msg
+        assert "teardown: ok" in msg
+
+    def test_unregistered_phases_skipped(self):
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]
+        diffs += [self.mkdiff(1000), self.mkdiff(2000)]  # call
+        t = DummyBisectTest(diffs)
+        t._bisect_phase_funs = {
+            "setup": None,
+            "call": noop,
+            "teardown": None,
+        }
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(noop, retries=2)
+        msg = str(exc.value)
+        assert "call: LEAKS" in msg
+        assert "setup" not in msg
+        assert "teardown" not in msg
+
+    def test_disabled_by_default(self):
+        t = DummyMemLeakTest([self.mkdiff(1000), self.mkdiff(2000)])
+        t._bisect_phase_funs = {"call": noop}
+        with pytest.raises(MemoryLeakError) as exc:
+            t.execute(noop, retries=2)
+        assert "Bisecting" not in str(exc.value)
+
+    def test_replay_times_seq_unpolluted(self, tmp_path):
+        # the phase re-runs must not leak their reduced `times` into
+        # the sequence recorded by the replay recipe, which must cover
+        # the main measurement loop only
+        diffs = [self.mkdiff(1000), self.mkdiff(2000)]  # main run
+        diffs += [self.mkdiff(0)]  # setup
+        diffs += [self.mkdiff(1000), self.mkdiff(2000)]  # call
+        diffs += [self.mkdiff(0)]  # teardown
+        t = DummyBisectTest(diffs)
+        t.replay_dir = str(tmp_path)
+        t._bisect_phase_funs = {
+            "setup": noop,
+            "call": noop,
+            "teardown": noop,
+        }
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, times=100, retries=2)
+        (path,) = tmp_path.glob("*.replay.json")
+        rec = json.loads(path.read_text())
+        assert rec["times_seq"] == [100, 150]
+
+    def test_leaktest_phase_validation(self):
+        with pytest.raises(TypeError):
+            psleak.LeakTest(noop, setup="not a callable")
+        with pytest.raises(TypeError):
+            psleak.LeakTest(noop, teardown="not a callable")
+
+
+# --- sample ring buffer
+
+
+class DummyRingTest(MemoryLeakTestCase):
+    def __init__(self):
+        super().__init__("runTest")
+        self._heap = 0
+
+    def _get_mem(self):
+        self._heap += 100  # steady per-sample growth
+        return {"heap": self._heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+    def _trim_mem(self):
+        pass
+
+    def call(self, fun):
+        return None
+
+
+class TestSampleRing:
+
+    def test_overwrites_oldest(self):
+        ring = psleak._SampleRing(4)
+        for i in range(6):
+            ring.add(i, {"heap": i})
+        rows = ring.rows()
+        assert len(rows) == 4
+        assert [r[0] for r in rows] == [2, 3, 4, 5]
+
+    def test_export_files(self, tmp_path):
+        t = DummyRingTest()
+        t.samples_dir = str(tmp_path)
+        with pytest.raises(MemoryLeakError):
+            t.execute(noop, times=10, retries=2, warmup_times=0)
+        (csv_path,) = tmp_path.glob("*.csv")
+        (trace_path,) = tmp_path.glob("*.trace.json")
+        lines = csv_path.read_text().splitlines()
+        assert lines[0].startswith("ncalls,elapsed,")
+        assert len(lines) > 2  # intermediate samples, not just endpoints
+        data = json.loads(trace_path.read_text())
+        counters = [e for e in data["traceEvents"] if e["ph"] == "C"]
+        assert any(e["name"] == "heap" for e in counters)
+
+    def test_exported_on_pass_too(self, tmp_path):
+        t = DummyRingTest()
+        t.samples_dir = str(tmp_path)
+        t.execute(noop, times=10, retries=1, warmup_times=0, tolerance=10**6)
+        assert list(tmp_path.glob("*.csv"))
+
+    def test_disabled_by_default(self, tmp_path):
+        t = DummyRingTest()
+        t.execute(noop, times=10, retries=1, warmup_times=0, tolerance=10**6)
+        assert t._ring is None
+        assert list(tmp_path.iterdir()) == []
@@ -2,10 +2,14 @@
 # Use of this source code is governed by a BSD-style license that can be
 # found in the LICENSE file.
 
+import asyncio
 import contextlib
 import io
+import mmap
 import os
 import socket
+import subprocess
+import sys
 import threading
 import time
 import unittest
@@ -13,6 +17,7 @@ import warnings
 from unittest import mock
 
 import pytest
+from psutil import LINUX
 from psutil import NETBSD
 from psutil import POSIX
 from psutil import WINDOWS
@@ -22,8 +27,11 @@ from psleak import Checkers
 from psleak import LeakTest
 from psleak import MemoryLeakError
 from psleak import MemoryLeakTestCase
+from psleak import UnclosedChildProcessError
 from psleak import UnclosedFdError
 from psleak import UnclosedHandleError
+from psleak import UnclosedMmapRegionError
+from psleak import UnclosedNativeThreadError
 from psleak import _emit_warnings
 
 from . import retry_on_failure
@@ -250,6 +258,293 @@ class TestMisc(MemoryLeakTestCase):
                 Test().test_it()
 
 
+@pytest.mark.skipif(not POSIX, reason="POSIX only")
+class TestIsolatedMode(MemoryLeakTestCase):
+    isolate = True
+
+    def test_success(self):
+        def fun():
+            return 1 + 1
+
+        self.execute(fun)
+
+    def test_leak_detected(self):
+        ls = []
+
+        def fun():
+            ls.append("x" * 248 * 1024)
+
+        with contextlib.redirect_stdout(io.StringIO()):
+            with pytest.raises(MemoryLeakError):
+                self.execute(fun, times=20, retries=3)
+
+    def test_exc_type_preserved(self):
+        def fun():
+            # fd is leaked in the worker process only; the worker exits
+            # right after reporting, so nothing to clean up here
+            os.open(os.devnull, os.O_RDONLY)
+
+        with pytest.raises(UnclosedFdError) as cm:
+            self.execute(fun)
+        assert cm.value.count == 1
+
+
+@pytest.mark.skipif(
+    not hasattr(psleak._psleak_ext, "sample_mem"),
+    reason="_psleak_ext not built",
+)
+class TestNativeSampler(unittest.TestCase):
+
+    def test_sample_mem(self):
+        heap, mmap_, uss, rss, vms = psleak._psleak_ext.sample_mem()
+        for value in (heap, mmap_, uss, rss, vms):
+            assert isinstance(value, int)
+            assert value >= 0
+        assert rss > 0
+        assert vms >= rss
+
+    def test_get_mem_uses_sampler(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        mem = MyTest()._get_mem()
+        assert sorted(mem) == ["heap", "mmap", "rss", "uss", "vms"]
+        assert mem["rss"] > 0
+
+    def test_get_mem_fallback(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        with mock.patch.object(psleak, "_psleak_ext", None):
+            mem = MyTest()._get_mem()
+        assert sorted(mem) == ["heap", "mmap", "rss", "uss", "vms"]
+        assert mem["rss"] > 0
+
+
+@pytest.mark.skipif(not POSIX, reason="POSIX only")
+class TestIsolatedRuns(unittest.TestCase):
+
+    def make_test(self):
+        class MyTest(MemoryLeakTestCase):
+            isolate_runs = True
+
+        t = MyTest()
+        t._trim_callback = None
+        return t
+
+    def test_child_state_stays_in_child(self):
+        ls = []
+        t = self.make_test()
+        diffs = t._call_ntimes(lambda: ls.append("x"), 10)
+        assert sorted(diffs) == sorted(t._get_mem())
+        # the appends happened in the fork()ed child only
+        assert ls == []
+
+    def test_exception_propagates(self):
+        def fun():
+            raise ZeroDivisionError
+
+        t = self.make_test()
+        with pytest.raises(ZeroDivisionError):
+            t._call_ntimes(fun, 3)
+
+
+@pytest.mark.skipif(
+    psleak._psleak_ext is None, reason="_psleak_ext not built"
+)
+class TestCallTrampoline(unittest.TestCase):
+
+    def test_call_ntimes(self):
+        calls = []
+        psleak._psleak_ext.call_ntimes(lambda: calls.append(1), 10)
+        assert len(calls) == 10
+
+    def test_exception_propagates(self):
+        def fun():
+            raise ZeroDivisionError
+
+        with pytest.raises(ZeroDivisionError):
+            psleak._psleak_ext.call_ntimes(fun, 3)
+
+    def test_used_when_call_not_overridden(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        assert MyTest()._use_call_trampoline()
+
+    def test_skipped_when_call_overridden(self):
+        calls = []
+
+        class MyTest(MemoryLeakTestCase):
+            def call(self, fun):
+                calls.append(1)
+                return fun()
+
+        t = MyTest()
+        assert not t._use_call_trampoline()
+        t._call_fun_ntimes(lambda: None, 5)
+        assert len(calls) == 5
+
+
+@pytest.mark.skipif(not LINUX, reason="LINUX only")
+class TestIncrementalFdDiff(unittest.TestCase):
+
+    def test_fd_snapshot(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        t = MyTest()
+        with open(__file__) as f:
+            snap = t._fd_snapshot()
+            fd = f.fileno()
+        assert snap[fd] == os.path.realpath(__file__)
+
+    def test_diff_fds_resolves_only_new_fds(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        t = MyTest()
+        with open(__file__) as f:
+            extras = t._diff_fds()
+            paths = [getattr(x, "path", None) for x in extras]
+            assert os.path.realpath(__file__) in paths
+            assert f.fileno() in [getattr(x, "fd", None) for x in extras]
+        # the cache was updated; with the file now closed there is
+        # nothing new to resolve
+        assert t._diff_fds() == []
+
+
+class TestClassFdBaseline(unittest.TestCase):
+
+    def test_shared_across_instances(self):
+        # one fd scan per class, not one per test instance
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        assert MyTest()._cached_fds is MyTest()._cached_fds
+
+    def test_not_shared_across_classes(self):
+        class A(MemoryLeakTestCase):
+            pass
+
+        class B(A):
+            pass
+
+        A()
+        B()
+        assert A.__dict__["_class_fds"] is not B.__dict__["_class_fds"]
+
+    def test_invalidated_on_fd_failure(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        t = MyTest()
+        t._diff_fds()  # what runs on UnclosedFdError
+        assert MyTest.__dict__["_class_fds"] is None
+        # the next instance takes a fresh baseline
+        assert MyTest()._cached_fds is not None
+
+    def test_warm_caches_once_per_process(self):
+        psleak._caches_warmed = False
+        try:
+            psleak.warm_caches()
+            assert psleak._caches_warmed
+        finally:
+            psleak._caches_warmed = True
+
+
+class TestSnapCounts(unittest.TestCase):
+
+    def test_matches_psutil(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        t = MyTest()
+        num_fds, num_threads, _, _ = t._snap_counts(
+            want_fds=POSIX, want_threads=True
+        )
+        assert num_threads == psleak.thisproc.num_threads()
+        if POSIX:
+            # the readdir of /proc/self/fd may or may not count its own
+            # directory fd depending on the implementation
+            assert abs(num_fds - psleak.thisproc.num_fds()) <= 1
+
+    def test_disabled_counters_not_collected(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        num_fds, num_threads, _, _ = MyTest()._snap_counts(
+            want_fds=False, want_threads=False
+        )
+        assert num_fds is None
+        assert num_threads is None
+
+    @pytest.mark.skipif(not LINUX, reason="LINUX only")
+    def test_tid_set(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        *_, tids = MyTest()._snap_counts(want_fds=False, want_threads=True)
+        assert threading.get_native_id() in tids
+
+
+class TestNativeThreadDiff(unittest.TestCase):
+
+    def snap_tids(self, t):
+        return t._snap_counts(want_fds=False, want_threads=True)[3]
+
+    @pytest.mark.skipif(not LINUX, reason="LINUX only")
+    def test_only_new_threads_resolved(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        t = MyTest()
+        before = self.snap_tids(t)
+        done = threading.Event()
+        thread = threading.Thread(target=done.wait)
+        thread.start()
+        try:
+            after = self.snap_tids(t)
+            extras = t._diff_native_threads(before, after)
+            assert [x.id for x in extras] == [thread.native_id]
+        finally:
+            done.set()
+            thread.join()
+
+    def test_fallback_without_tid_sets(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        extras = MyTest()._diff_native_threads(None, None)
+        assert len(extras) == psleak.thisproc.num_threads()
+
+
+class TestInterpose:
+
+    def test_not_loaded(self, monkeypatch):
+        monkeypatch.setattr(psleak, "_interpose_counters", None)
+        monkeypatch.delenv("LD_PRELOAD", raising=False)
+        assert psleak._load_interpose() is False
+
+    def test_get_mem_exact_metrics(self, monkeypatch):
+        class FakeCounter:
+            def __init__(self, value):
+                self.value = value
+
+        monkeypatch.setattr(
+            psleak,
+            "_interpose_counters",
+            (FakeCounter(123), FakeCounter(456)),
+        )
+
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        mem = MyTest()._get_mem()
+        assert mem["heap_exact"] == 123
+        assert mem["mmap_exact"] == 456
+
+
 class TestCheckers:
 
     def test_default_values(self):
@@ -299,6 +594,131 @@ class TestCheckers:
             assert getattr(checkers, f)
 
 
+class TestCheckerPlan:
+
+    def test_cached_per_config(self):
+        # equal (frozen) configs share one compiled plan
+        p1 = psleak._compile_checkers(Checkers.only("fds"))
+        p2 = psleak._compile_checkers(Checkers.only("fds"))
+        assert p1 is p2
+        p3 = psleak._compile_checkers(Checkers.only("c_threads"))
+        assert p1 is not p3
+
+    def test_entries(self):
+        plan = psleak._compile_checkers(Checkers())
+        names = [name for name, *_ in plan.entries]
+        assert names[0] == "py_threads"
+        if POSIX:
+            assert "num_fds" in names
+            assert not any(
+                n in names for n in ("num_handles", "heap_count")
+            )
+        assert plan.exceptions["c_threads"] is UnclosedNativeThreadError
+
+    def test_disabled_checkers_absent(self):
+        plan = psleak._compile_checkers(Checkers.only("memory"))
+        if WINDOWS:
+            assert len(plan.entries) == 1  # heap_count
+        else:
+            assert plan.entries == ()
+        assert not plan.want_fds
+        assert not plan.want_threads
+        assert plan.memory
+
+
+class FakeResourceError(psleak.UnclosedResourceError):
+    resource_name = "fake resource"
+
+
+class TestCheckerRegistry(unittest.TestCase):
+
+    def setUp(self):
+        for name in list(psleak._checker_registry):
+            psleak.unregister_checker(name)
+
+    tearDown = setUp
+
+    def test_validation(self):
+        with pytest.raises(TypeError, match="counter"):
+            psleak.register_checker("fake", "nope", FakeResourceError)
+        with pytest.raises(TypeError, match="UnclosedResourceError"):
+            psleak.register_checker("fake", lambda: 0, ValueError)
+        with pytest.raises(ValueError, match="built-in"):
+            psleak.register_checker("num_fds", lambda: 0, FakeResourceError)
+        psleak.register_checker("fake", lambda: 0, FakeResourceError)
+        with pytest.raises(ValueError, match="already registered"):
+            psleak.register_checker("fake", lambda: 0, FakeResourceError)
+        with pytest.raises(ValueError, match="no registered checker"):
+            psleak.unregister_checker("bogus")
+
+    def test_registration_invalidates_plan_cache(self):
+        p1 = psleak._compile_checkers(Checkers())
+        psleak.register_checker("fake", lambda: 0, FakeResourceError)
+        p2 = psleak._compile_checkers(Checkers())
+        assert p1 is not p2
+        assert "fake" in [name for name, *_ in p2.entries]
+        psleak.unregister_checker("fake")
+        p3 = psleak._compile_checkers(Checkers())
+        assert "fake" not in [name for name, *_ in p3.entries]
+
+    def test_leak_detected_extras_lazy(self):
+        state = {"count": 0, "extras_calls": 0}
+
+        def extras():
+            state["extras_calls"] += 1
+            return ["fake-resource-1"]
+
+        psleak.register_checker(
+            "fake",
+            counter=lambda: state["count"],
+            exception=FakeResourceError,
+            extras=extras,
+        )
+
+        def fun():
+            state["count"] += 1
+
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        with pytest.raises(FakeResourceError) as cm:
+            MyTest().execute(fun, checkers=Checkers.exclude("memory"))
+        assert state["extras_calls"] == 1  # failure path only
+        assert "fake-resource-1" in str(cm.value)
+
+    def test_extras_not_fetched_on_pass(self):
+        calls = []
+        psleak.register_checker(
+            "fake",
+            counter=lambda: 0,
+            exception=FakeResourceError,
+            extras=lambda: calls.append(1),
+        )
+
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        MyTest().execute(lambda: None, checkers=Checkers.exclude("memory"))
+        assert calls == []
+
+    def test_no_extras_callable(self):
+        state = {"count": 0}
+        psleak.register_checker(
+            "fake",
+            counter=lambda: state["count"],
+            exception=FakeResourceError,
+        )
+
+        def fun():
+            state["count"] += 1
+
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        with pytest.raises(FakeResourceError, match="1 unclosed"):
+            MyTest().execute(fun, checkers=Checkers.exclude("memory"))
+
+
 class TestMemoryLeakTestCaseConfig:
 
     def test_memory_disabled(self):
@@ -463,3 +883,316 @@ class TestAutoGenerate(unittest.TestCase):
 
                 def test_leak_foo(self):
                     pass
+
+
+class TestExecuteAsync(unittest.TestCase):
+
+    def make_case(self):
+        class Test(MemoryLeakTestCase):
+            checkers = Checkers.only("async_tasks")
+
+        return Test("runTest")
+
+    def test_not_a_coroutine(self):
+        with pytest.raises(TypeError, match="coroutine"):
+            self.make_case().execute_async(lambda: None)
+
+    def test_incompatible_with_isolate(self):
+        async def coro():
+            pass
+
+        with pytest.raises(ValueError, match="isolate"):
+            self.make_case().execute_async(coro, isolate=True)
+        with pytest.raises(ValueError, match="isolate"):
+            self.make_case().execute_async(coro, isolate_runs=True)
+
+    def test_clean_coroutine(self):
+        async def coro():
+            await asyncio.sleep(0)
+
+        self.make_case().execute_async(coro)
+
+    def test_loop_reused_and_closed(self):
+        loops = []
+
+        async def coro():
+            loops.append(asyncio.get_running_loop())
+
+        case = self.make_case()
+        case.execute_async(coro)
+        assert len(set(map(id, loops))) == 1
+        assert loops[0].is_closed()
+        assert case._async_loop is None
+
+    def test_pending_task_detected(self):
+        holder = []
+
+        async def leaky():
+            holder.append(asyncio.create_task(asyncio.sleep(10)))
+
+        with pytest.raises(psleak.UnclosedAsyncResourceError):
+            self.make_case().execute_async(leaky)
+
+    def test_args_forwarded(self):
+        got = []
+
+        async def coro(x, y):
+            got.append((x, y))
+
+        self.make_case().execute_async(coro, 1, 2)
+        assert got[-1] == (1, 2)
+
+
+def noop():
+    pass
+
+
+class TestSharedWarmup(unittest.TestCase):
+
+    def setUp(self):
+        psleak._warmed_groups.clear()
+
+    tearDown = setUp
+
+    def test_warmup_once_per_group(self):
+        calls = []
+
+        def fun(x):
+            calls.append(x)
+
+        class Test(MemoryLeakTestCase):
+            checkers = Checkers.only("memory")
+            warmup_times = 5
+            times = 1
+            retries = 1
+            tolerance = 10**9
+
+            @classmethod
+            def auto_generate(cls):
+                return {"a": LeakTest(fun, 1), "b": LeakTest(fun, 2)}
+
+        Test("test_leak_a").test_leak_a()
+        # 5 warmup + 1 counter-check call + 1 measured call
+        first = len(calls)
+        assert first == 7
+        Test("test_leak_b").test_leak_b()
+        # sibling shares the warmed function: no warmup calls
+        assert len(calls) - first == 2
+
+    def test_distinct_funs_not_grouped(self):
+        calls_a = []
+        calls_b = []
+
+        class Test(MemoryLeakTestCase):
+            checkers = Checkers.only("memory")
+            warmup_times = 5
+            times = 1
+            retries = 1
+            tolerance = 10**9
+
+            @classmethod
+            def auto_generate(cls):
+                return {
+                    "a": LeakTest(calls_a.append, 1),
+                    "b": LeakTest(calls_b.append, 1),
+                }
+
+        Test("test_leak_a").test_leak_a()
+        Test("test_leak_b").test_leak_b()
+        assert len(calls_a) == 7
+        assert len(calls_b) == 7
+
+    def test_warm_group_cleared(self):
+        class Test(MemoryLeakTestCase):
+            checkers = Checkers.only("memory")
+            warmup_times = 0
+            times = 1
+            retries = 1
+            tolerance = 10**9
+
+            @classmethod
+            def auto_generate(cls):
+                return {"a": LeakTest(noop)}
+
+        t = Test("test_leak_a")
+        t.test_leak_a()
+        assert t._warm_group is None
+
+
+class TestSharedBaseline(unittest.TestCase):
+
+    class Dummy(MemoryLeakTestCase):
+        checkers = Checkers.only("memory")
+
+        def __init__(self, mems):
+            super().__init__("runTest")
+            self._mems = iter(mems)
+            self.trims = 0
+
+        def _get_mem(self):
+            heap = next(self._mems)
+            return {"heap": heap, "uss": 0, "rss": 0, "vms": 0, "mmap": 0}
+
+        def _trim_mem(self):
+            self.trims += 1
+
+        def call(self, fun):
+            return None
+
+    def test_baseline_reused_within_group(self):
+        # the first sample is consumed by tolerance normalization;
+        # run 1 then samples 0 -> 1000 (unstable); run 2 reuses the
+        # 1000 baseline and samples 2000 (growth stopped): 3
+        # measurement samples and 3 trims instead of 4 each
+        t = self.Dummy([0, 0, 1000, 2000])
+        t._warm_group = noop
+        psleak._warmed_groups.add(noop)
+        try:
+            t.execute(noop, warmup_times=0, retries=2)
+        finally:
+            psleak._warmed_groups.discard(noop)
+        assert t.trims == 3
+        assert t._shared_baseline is None
+
+    def test_no_reuse_outside_group(self):
+        # tolerance sample, then both runs trim and sample twice
+        t = self.Dummy([0, 0, 1000, 1000, 2000])
+        t.execute(noop, warmup_times=0, retries=2)
+        assert t.trims == 4
+
+
+class TestHandleSnapshot(unittest.TestCase):
+
+    def test_diff_handle_types(self):
+        class T(MemoryLeakTestCase):
+            pass
+
+        before = {"Event": 3, "File": 10}
+        after = {"Event": 5, "File": 10, "Mutant": 1}
+        assert T()._diff_handle_types(before, after) == [
+            "Event: +2",
+            "Mutant: +1",
+        ]
+
+    @pytest.mark.skipif(not WINDOWS, reason="WINDOWS only")
+    @pytest.mark.skipif(
+        not hasattr(psleak._psleak_ext, "handle_counts"),
+        reason="C ext not built",
+    )
+    def test_native_counts(self):
+        counts = psleak._psleak_ext.handle_counts()
+        assert sum(counts.values()) > 0
+        assert all(isinstance(k, str) for k in counts)
+
+        class T(MemoryLeakTestCase):
+            pass
+
+        total, extras = T()._snap_handles()
+        assert total == sum(extras.values())
+
+
+class TestTrackChildren(unittest.TestCase):
+
+    def spawn(self, code="import time; time.sleep(60)"):
+        proc = subprocess.Popen([sys.executable, "-c", code])
+        self.addCleanup(proc.wait)
+        self.addCleanup(proc.kill)
+        return proc
+
+    def make_test(self):
+        class MyTest(MemoryLeakTestCase):
+            track_children = True
+
+        return MyTest()
+
+    def test_plan_entry(self):
+        plan = psleak._compile_checkers(Checkers(), True)
+        names = [name for name, *_ in plan.entries]
+        assert names[-1] == "child_procs"
+        plan = psleak._compile_checkers(Checkers(), False)
+        assert "child_procs" not in [name for name, *_ in plan.entries]
+
+    def test_scan_children(self):
+        t = self.make_test()
+        proc = self.spawn()
+        pids, num_fds, num_threads, rss, vms = t._scan_children()
+        assert proc.pid in pids
+        assert num_threads >= len(pids)
+        assert rss > 0
+        assert vms >= rss
+
+    def test_mem_metrics(self):
+        t = self.make_test()
+        self.spawn()
+        mem = t._get_mem()
+        assert mem["children_rss"] > 0
+        assert mem["children_vms"] >= mem["children_rss"]
+
+    def test_disabled_by_default(self):
+        class MyTest(MemoryLeakTestCase):
+            pass
+
+        assert "children_rss" not in MyTest()._get_mem()
+
+    def test_leaked_child_detected(self):
+        def fun():
+            self.spawn()
+
+        t = self.make_test()
+        with pytest.raises(UnclosedChildProcessError):
+            t.execute(fun, checkers=Checkers.exclude("memory"))
+
+    def test_reaped_child_passes(self):
+        def fun():
+            subprocess.check_call([sys.executable, "-c", "pass"])
+
+        t = self.make_test()
+        t.execute(fun, checkers=Checkers.exclude("memory"))
+
+
+@pytest.mark.skipif(not LINUX, reason="LINUX only")
+class TestTrackMmapRegions(unittest.TestCase):
+
+    def make_test(self):
+        class MyTest(MemoryLeakTestCase):
+            track_mmap_regions = True
+
+        return MyTest()
+
+    def test_plan_entry(self):
+        plan = psleak._compile_checkers(Checkers(), mmap_regions=True)
+        assert "mmap_regions" in [name for name, *_ in plan.entries]
+        plan = psleak._compile_checkers(Checkers())
+        assert "mmap_regions" not in [name for name, *_ in plan.entries]
+
+    def test_snapshot(self):
+        t = self.make_test()
+        count, hashes = t._snap_mmap_regions()
+        assert count == len(hashes)
+        assert count > 0
+        m = mmap.mmap(-1, 4 * 1024 * 1024)
+        try:
+            count2, _ = t._snap_mmap_regions()
+            assert count2 > count
+        finally:
+            m.close()
+
+    def test_leaked_region_detected(self):
+        leaked = []
+        self.addCleanup(lambda: [m.close() for m in leaked])
+
+        def fun():
+            leaked.append(mmap.mmap(-1, 4 * 1024 * 1024))
+
+        t = self.make_test()
+        with pytest.raises(UnclosedMmapRegionError) as exc:
+            t.execute(fun, checkers=Checkers.exclude("memory"))
+        assert "4194304 bytes" in str(exc.value)
+
+    def test_unmapped_region_passes(self):
+        def fun():
+            m = mmap.mmap(-1, 4 * 1024 * 1024)
+            m.close()
+
+        t = self.make_test()
+        t.execute(fun, checkers=Checkers.exclude("memory"))
@@ -2,6 +2,8 @@
 # Use of this source code is governed by a BSD-style license that can be
 # found in the LICENSE file.
 
+import gc
+import sys
 import threading
 
 import pytest
@@ -133,3 +135,97 @@ class TestGCDebugger(MemoryLeakTestCase):
         # contents are either scalar or transient.
         for obj in nested:
             assert dbg.is_transient(obj)
+
+    def test_deeply_nested(self):
+        # the traversal is iterative so it must not hit the recursion
+        # limit no matter how deep the container graph is
+        obj = []
+        for _ in range(sys.getrecursionlimit() * 2):
+            obj = [obj]
+        with GCDebugger() as dbg:
+            pass
+        assert dbg.is_transient(obj)
+
+    def test_self_cycle(self):
+        a = []
+        a.append(a)
+        with GCDebugger() as dbg:
+            pass
+        assert dbg.is_transient(a)
+
+    def test_non_transient(self):
+        class Foo:
+            pass
+
+        with GCDebugger() as dbg:
+            pass
+        obj = [1, Foo()]
+        assert not dbg.is_transient(obj)
+        # the verdict is memoized
+        assert dbg._memo[id(obj)] is False
+        assert not dbg.is_transient(obj)
+
+    def test_leaked_objects_identity(self):
+        # membership in `before` is judged by identity, not equality:
+        # an equal-but-distinct object must still be reported
+        class Foo:
+            pass
+
+        with GCDebugger() as dbg:
+            pass
+        one, two = Foo(), Foo()
+        dbg.before = [one]
+        dbg.after = [one, two]
+        assert dbg.leaked_objects() == [two]
+
+
+class TestGCDebuggerYoungGen(MemoryLeakTestCase):
+
+    def test_invalid_generation(self):
+        with pytest.raises(ValueError, match="generation"):
+            GCDebugger(generation=3)
+
+    def test_detects_cycle_in_window(self):
+        class Leaky:
+            def __init__(self):
+                self.ref = self
+
+        with GCDebugger(generation=0) as dbg:
+            Leaky()
+        assert any(isinstance(x, Leaky) for x in dbg.leaked_objects())
+
+    def test_clean_window(self):
+        with GCDebugger(generation=0) as dbg:
+            x = [object() for _ in range(100)]
+            del x
+        assert dbg.leaked_objects() == []
+
+    def test_callback_unregistered(self):
+        with GCDebugger(generation=0) as dbg:
+            assert dbg._on_collect in gc.callbacks
+        assert dbg._on_collect not in gc.callbacks
+
+    def test_promotion_extends_sweep(self):
+        class Leaky:
+            def __init__(self):
+                self.ref = self
+
+        with GCDebugger(generation=0) as dbg:
+            Leaky()
+            # a full collection inside the window promotes survivors;
+            # the exit sweep must extend to the oldest gen collected
+            gc.collect()
+        assert dbg._max_gen == 2
+        assert any(isinstance(x, Leaky) for x in dbg.leaked_objects())
+
+    def test_checker_integration(self):
+        class Leaky:
+            def __init__(self):
+                self.ref = self
+
+        class Test(MemoryLeakTestCase):
+            checkers = Checkers.only("gcgarbage")
+            gc_generation = 0
+
+        with pytest.raises(UncollectableGarbageError):
+            Test("runTest").execute(Leaky)